@@ -22,14 +22,6 @@ void errorCallback(char* error)
     Serial.println(error);
 }
 
-void LoRaWANLoopTask(void* arg)
-{
-    while (1) {
-        lorawan.update();
-        vTaskDelay(5);
-    }
-}
-
 void setup()
 {
     M5.begin();
@@ -70,7 +62,8 @@ void setup()
     Serial.println("[Config] Link check set successfully.");
     lorawan.onError(errorCallback);
     Serial.println("set Init OK");
-    xTaskCreate(LoRaWANLoopTask, "LoRaWANLoopTask", 1024 * 10, NULL, 5, NULL);
+    // Handle received frames and events as soon as the module sends them
+    lorawan.beginReceive(1024 * 10);
 }
 
 void loop()
@@ -86,26 +79,24 @@ void loop()
             Serial.println("send fail");
         }
     }
-    if (lorawan.available()) {
-        std::vector<lorawan_frame_t> frames = lorawan.read();
-        for (int i = 0; i < frames.size(); i++) {
-            Serial.print("RSSI: ");
-            Serial.println(frames[i].rssi);
-            Serial.print("SNR: ");
-            Serial.println(frames[i].snr);
-            Serial.print("LEN: ");
-            Serial.println(frames[i].len);
-            Serial.print("PORT: ");
-            Serial.println(frames[i].port);
-            Serial.print("UNICAST: ");
-            Serial.println(frames[i].unicast);
-            Serial.print("Payload: ");
-            for (uint8_t j = 0; j < frames[i].len; j++) {
-                Serial.printf("%02X", frames[i].payload[j]);
-            }
-            Serial.println();
+    const lorawan_frame_t* frame;
+    while ((frame = lorawan.peek()) != nullptr) {
+        Serial.print("RSSI: ");
+        Serial.println(frame->rssi);
+        Serial.print("SNR: ");
+        Serial.println(frame->snr);
+        Serial.print("LEN: ");
+        Serial.println(frame->len);
+        Serial.print("PORT: ");
+        Serial.println(frame->port);
+        Serial.print("UNICAST: ");
+        Serial.println(frame->unicast);
+        Serial.print("Payload: ");
+        for (uint8_t j = 0; j < frame->len; j++) {
+            Serial.printf("%02X", frame->payload[j]);
         }
-        lorawan.flush();
+        Serial.println();
+        lorawan.pop();
     }
     if (Serial.available()) {             // If the serial port reads data.
         String ch = Serial.readString();  // Copy the data read from the serial port
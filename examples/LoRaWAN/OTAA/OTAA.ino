@@ -21,17 +21,21 @@ RAK3172LoRaWAN lorawan;
 
 void joinCallback(bool status)
 {
+    lorawan_join_stats_t stats;
+    lorawan.getJoinStats(&stats);
     if (status) {
         Serial.println("[LoRaWAN] Join network successful!");
         Serial.println("Device EUI: " + String(DEVEUI));
+        Serial.printf("[LoRaWAN] Joined after %lu attempts in %lu ms\n", (unsigned long)stats.attempts,
+                      (unsigned long)stats.time_to_join_ms);
     } else {
-        Serial.println("[LoRaWAN] Join network failed!");
+        Serial.printf("[LoRaWAN] Join network failed, next attempt in %lu ms\n", (unsigned long)stats.next_attempt_ms);
     }
 }
 
 void sendCallback()
 {
-    Serial.println("[LoRaWAN] Uplink confirmed by server");
+    Serial.println("[LoRaWAN] Uplink sent");
 }
 
 void errorCallback(char* error)
@@ -40,14 +44,6 @@ void errorCallback(char* error)
     Serial.println(error);
 }
 
-void LoRaWANLoopTask(void* arg)
-{
-    while (1) {
-        lorawan.update();
-        vTaskDelay(5);
-    }
-}
-
 void setup()
 {
     M5.begin();
@@ -84,24 +80,26 @@ void setup()
         delay(1000);
     }
     Serial.println("[Config] Data rate set successfully.");
+    lorawan.onSend(sendCallback);
+    lorawan.onJoin(joinCallback);
+    lorawan.onError(errorCallback);
+    Serial.println("set Init OK");
+    // Handle received frames and events as soon as the module sends them
+    lorawan.beginReceive(1024 * 10);
+    // Join in the background, retrying with backoff until the network accepts the device
     Serial.println("[Info] Attempting to join the network...");
-    if (lorawan.join(true, false, 10, 10)) {
+    if (lorawan.beginJoin()) {
         Serial.println("Start Join...");
     } else {
         Serial.println("Join Fail");
     }
-    lorawan.onSend(sendCallback);
-    lorawan.onJoin(joinCallback);
-    lorawan.onError(errorCallback);
-    Serial.println("set Init OK");
-    xTaskCreate(LoRaWANLoopTask, "LoRaWANLoopTask", 1024 * 10, NULL, 5, NULL);
 }
 
 void loop()
 {
     M5.update();
     if (M5.BtnA.wasReleased()) {
-        if (lorawan.join(true, false, 10, 10)) {
+        if (lorawan.beginJoin()) {
             Serial.println("Start Join...");
         } else {
             Serial.println("Join Fail");
@@ -109,32 +107,35 @@ void loop()
     }
     if (M5.BtnB.wasReleased()) {
         String data = "UPlink LoRaWAN Frame: " + String(millis());
-        if (lorawan.send(data)) {
+        // Uplinks sent before the device has joined are held and sent once it joins
+        lorawan_send_status_t status;
+        lorawan.send(data, 1, &status);
+        if (status == LORAWAN_SEND_OK) {
             Serial.println("send Successful");
+        } else if (status == LORAWAN_SEND_HELD) {
+            Serial.println("send held until joined");
         } else {
             Serial.println("send fail");
         }
     }
-    if (lorawan.available()) {
-        std::vector<lorawan_frame_t> frames = lorawan.read();
-        for (int i = 0; i < frames.size(); i++) {
-            Serial.print("RSSI: ");
-            Serial.println(frames[i].rssi);
-            Serial.print("SNR: ");
-            Serial.println(frames[i].snr);
-            Serial.print("LEN: ");
-            Serial.println(frames[i].len);
-            Serial.print("PORT: ");
-            Serial.println(frames[i].port);
-            Serial.print("UNITCAST: ");
-            Serial.println(frames[i].unicast);
-            Serial.print("Payload: ");
-            for (uint8_t j = 0; j < frames[i].len; j++) {
-                Serial.printf("%02X", frames[i].payload[j]);
-            }
-            Serial.println();
+    const lorawan_frame_t* frame;
+    while ((frame = lorawan.peek()) != nullptr) {
+        Serial.print("RSSI: ");
+        Serial.println(frame->rssi);
+        Serial.print("SNR: ");
+        Serial.println(frame->snr);
+        Serial.print("LEN: ");
+        Serial.println(frame->len);
+        Serial.print("PORT: ");
+        Serial.println(frame->port);
+        Serial.print("UNITCAST: ");
+        Serial.println(frame->unicast);
+        Serial.print("Payload: ");
+        for (uint8_t j = 0; j < frame->len; j++) {
+            Serial.printf("%02X", frame->payload[j]);
         }
-        lorawan.flush();
+        Serial.println();
+        lorawan.pop();
     }
     if (Serial.available()) {             // If the serial port reads data.
         String ch = Serial.readString();  // Copy the data read from the serial port
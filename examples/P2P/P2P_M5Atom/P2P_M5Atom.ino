@@ -36,12 +36,13 @@ void setup()
     }
 
     lora.setMode(P2P_TX_RX_MODE);
+    // Handle received frames as soon as the module sends them
+    lora.beginReceive(1024 * 10);
 }
 
 void loop()
 {
     M5.update();
-    lora.update();
     if (M5.Btn.wasPressed()) {
         Serial.printf("M5.Btn.wasPressed\n");
         String message = "Hello:" + String(msgCount);
@@ -67,21 +68,19 @@ void loop()
         lora.setMode(P2P_TX_RX_MODE);
         delay(1000);
     }
-    if (lora.available()) {
-        std::vector<p2p_frame_t> frames = lora.read();
-        for (int i = 0; i < frames.size(); i++) {
-            Serial.print("RSSI: ");
-            Serial.print(frames[i].rssi);
-            Serial.print(" SNR: ");
-            Serial.print(frames[i].snr);
-            Serial.print(" LEN: ");
-            Serial.print(frames[i].len);
-            Serial.print(" Payload: ");
-            for (uint8_t j = 0; j < frames[i].len; j++) {
-                Serial.printf("%02X", frames[i].payload[j]);
-            }
-            Serial.println();
+    const p2p_frame_t* frame;
+    while ((frame = lora.peek()) != nullptr) {
+        Serial.print("RSSI: ");
+        Serial.print(frame->rssi);
+        Serial.print(" SNR: ");
+        Serial.print(frame->snr);
+        Serial.print(" LEN: ");
+        Serial.print(frame->len);
+        Serial.print(" Payload: ");
+        for (uint8_t j = 0; j < frame->len; j++) {
+            Serial.printf("%02X", frame->payload[j]);
         }
-        lora.flush();
+        Serial.println();
+        lora.pop();
     }
 }
\ No newline at end of file
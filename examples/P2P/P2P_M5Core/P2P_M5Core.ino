@@ -23,14 +23,6 @@ int cr       = 0;
 int sf       = 12;
 int bw       = 125;
 
-void LoRaLoopTask(void* arg)
-{
-    while (1) {
-        lora.update();
-        vTaskDelay(5);
-    }
-}
-
 void beep()
 {
     M5.Speaker.tone(2000, 100);
@@ -52,7 +44,8 @@ void setup()
     }
 
     lora.setMode(P2P_TX_RX_MODE);
-    xTaskCreate(LoRaLoopTask, "LoRaLoopTask", 1024 * 10, NULL, 2, NULL);
+    // Handle received frames and events as soon as the module sends them
+    lora.beginReceive(1024 * 10);
 }
 
 void loop()
@@ -85,22 +78,20 @@ void loop()
             msgCount++;
         }
     }
-    if (lora.available()) {
-        std::vector<p2p_frame_t> frames = lora.read();
-        for (int i = 0; i < frames.size(); i++) {
-            beep();
-            Serial.print("RSSI: ");
-            Serial.print(frames[i].rssi);
-            Serial.print(" SNR: ");
-            Serial.print(frames[i].snr);
-            Serial.print(" LEN: ");
-            Serial.print(frames[i].len);
-            Serial.print(" Payload: ");
-            for (uint8_t j = 0; j < frames[i].len; j++) {
-                Serial.printf("%02X", frames[i].payload[j]);
-            }
-            Serial.println();
+    const p2p_frame_t* frame;
+    while ((frame = lora.peek()) != nullptr) {
+        beep();
+        Serial.print("RSSI: ");
+        Serial.print(frame->rssi);
+        Serial.print(" SNR: ");
+        Serial.print(frame->snr);
+        Serial.print(" LEN: ");
+        Serial.print(frame->len);
+        Serial.print(" Payload: ");
+        for (uint8_t j = 0; j < frame->len; j++) {
+            Serial.printf("%02X", frame->payload[j]);
         }
-        lora.flush();
+        Serial.println();
+        lora.pop();
     }
 }
@@ -6,167 +6,874 @@
 
 #include "rak3172_common.hpp"
 
-String encodeMsg(String str)
+// Longest sleep of the receive task before it checks whether it has to stop
+#define RECEIVE_WAIT_MS 1000
+
+static const struct {
+    const char* line;
+    rak3172_result_t result;
+} _result_lines[] = {
+    {"OK", RAK3172_RESULT_OK},
+    {"AT_ERROR", RAK3172_RESULT_ERROR},
+    {"AT_PARAM_ERROR", RAK3172_RESULT_PARAM_ERROR},
+    {"AT_BUSY_ERROR", RAK3172_RESULT_BUSY_ERROR},
+    {"AT_TEST_PARAM_OVERFLOW", RAK3172_RESULT_PARAM_OVERFLOW},
+    {"AT_NO_CLASSB_ENABLE", RAK3172_RESULT_NO_CLASSB_ENABLE},
+    {"AT_NO_NETWORK_JOINED", RAK3172_RESULT_NO_NETWORK_JOINED},
+    {"AT_RX_ERROR", RAK3172_RESULT_RX_ERROR},
+    {"AT_MODE_NO_SUPPORT", RAK3172_RESULT_MODE_NO_SUPPORT},
+    {"AT_COMMAND_NOT_FOUND", RAK3172_RESULT_COMMAND_NOT_FOUND},
+};
+
+#if defined RAK3172_USE_FREERTOS
+typedef struct {
+    char cmd[RAK3172_ASYNC_COMMAND_SIZE];
+    uint32_t timeout_ms;
+    rak3172_command_cb_t callback;
+    void* ctx;
+    rak3172_future_t* future;
+} rak3172_async_command_t;
+#endif
+
+static bool matchResultLine(const char* line, size_t len, rak3172_result_t* result)
 {
-    char buf[str.length() + 1];
-    char tempbuf[((str.length() + 1) * 2)];
-    str.toCharArray(buf, str.length() + 1);
-    int i = 0;
-    for (const char* p = buf; *p; ++p) {
-        sprintf((char*)(tempbuf + i), "%02x", *p);
-        i += 2;
+    if (len > 0 && line[len - 1] == '\r') {
+        len--;
+    }
+    for (size_t i = 0; i < sizeof(_result_lines) / sizeof(_result_lines[0]); i++) {
+        if (strlen(_result_lines[i].line) == len && memcmp(_result_lines[i].line, line, len) == 0) {
+            *result = _result_lines[i].result;
+            return true;
+        }
     }
-    return String(tempbuf);
+    return false;
 }
 
-String decodeMsg(String hexEncoded)
+// Event names after "+EVT:", sorted for the binary search in parseEvent()
+static const struct {
+    const char* name;
+    rak3172_event_type_t type;
+} _event_names[] = {
+    {"JOINED", RAK3172_EVENT_JOINED},
+    {"JOIN_FAILED", RAK3172_EVENT_JOIN_FAILED},
+    {"JOIN_FAILED_RX_TIMEOUT", RAK3172_EVENT_JOIN_FAILED},
+    {"LINKCHECK", RAK3172_EVENT_LINKCHECK},
+    {"RXP2P", RAK3172_EVENT_RXP2P},
+    {"RX_1", RAK3172_EVENT_RX},
+    {"RX_2", RAK3172_EVENT_RX},
+    {"RX_B", RAK3172_EVENT_RX},
+    {"RX_C", RAK3172_EVENT_RX},
+    {"SEND_CONFIRMED_FAILED", RAK3172_EVENT_SEND_CONFIRMED_FAILED},
+    {"SEND_CONFIRMED_OK", RAK3172_EVENT_SEND_CONFIRMED_OK},
+    {"TXP2P", RAK3172_EVENT_TXP2P_DONE},
+    {"TX_DONE", RAK3172_EVENT_TX_DONE},
+};
+
+#if RAK3172_CACHE_SIZE > 0
+// Parameters that never change while the module is powered
+static const char* const _cache_immutable[] = {
+    "VER", "BUILDTIME", "HWID", "SN", "HWMODEL", "CLIVER", "APIVER", "REPOINFO",
+};
+
+// Actions, measurements and status values, which are never cached
+static const char* const _cache_uncached[] = {
+    "SEND", "PSEND", "JOIN", "SLEEP", "PRECV", "ADDMULC", "RMVMULC", "BAT", "SYSV", "NJS",
+    "DUTYTIME", "LTIME", "RSSI", "SNR", "ARSSI", "TIMEREQ", "LSTMULC", "NETID", "CHS",
+};
+
+// LoRaWAN parameters the network changes on its own through ADR and MAC commands
+static const char* const _cache_network[] = {
+    "DR", "TXP", "MASK", "RX1DL", "RX2DL", "RX2DR", "RX2FQ",
+};
+
+// Parameters whose change also changes other parameters
+static const char* const _cache_coupled[] = {
+    "NWM", "BAND", "P2P", "PFREQ", "PSF", "PBW", "PCR", "PPL", "PTP",
+};
+
+static bool inList(const char* verb, const char* const* list, size_t count)
 {
-    if ((hexEncoded.length() % 2) == 0) {
-        char buf[hexEncoded.length() + 1];
-        char tempbuf[((hexEncoded.length() + 1))];
-        hexEncoded.toCharArray(buf, hexEncoded.length() + 1);
-        int i = 0;
-        for (int loop = 2; loop < hexEncoded.length() + 1; loop += 2) {
-            String tmpstr = hexEncoded.substring(loop - 2, loop);
-            sprintf(&tempbuf[i], "%c", (int)strtoul(tmpstr.c_str(), nullptr, 16));
-            i++;
-        }
-        return String(tempbuf);
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(verb, list[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool isImmutable(const char* verb)
+{
+    return inList(verb, _cache_immutable, sizeof(_cache_immutable) / sizeof(_cache_immutable[0]));
+}
+
+static bool isUncached(const char* verb)
+{
+    return inList(verb, _cache_uncached, sizeof(_cache_uncached) / sizeof(_cache_uncached[0]));
+}
+
+// Splits "AT+KEY=value" into its verb and value; `*value` is nullptr for queries ("AT+KEY=?", "AT+KEY?").
+static bool splitCommand(const char* cmd, char* verb, size_t verb_size, const char** value)
+{
+    if (strncmp(cmd, "AT+", 3) != 0) {
+        return false;
+    }
+    cmd += 3;
+    size_t len = strcspn(cmd, "=?");
+    if (len == 0 || len >= verb_size) {
+        return false;
+    }
+    memcpy(verb, cmd, len);
+    verb[len] = '\0';
+    if (cmd[len] == '?' || strcmp(cmd + len, "=?") == 0) {
+        *value = nullptr;
+    } else if (cmd[len] == '=') {
+        *value = cmd + len + 1;
     } else {
+        // Argument-less command such as "AT+SLEEP"
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Two lowercase hex digits per byte value, indexed by 2 * byte
+static const char _hex_pairs[] =
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+// Nibble value of every ASCII character, 0xff for characters that are not hex digits
+static const uint8_t _hex_values[256] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+size_t bytes2hex(const uint8_t* buf, size_t size, char* hex, size_t hex_size)
+{
+    if (hex_size < size * 2 + 1) {
+        return 0;
+    }
+    for (size_t i = 0; i < size; i++) {
+        memcpy(hex + i * 2, &_hex_pairs[buf[i] * 2], 2);
+    }
+    hex[size * 2] = '\0';
+    return size * 2;
+}
+
+int hex2bytes(const char* hex, size_t len, uint8_t* buf, size_t size)
+{
+    if ((len & 1) != 0 || len / 2 > size) {
+        return -1;
+    }
+    for (size_t i = 0; i < len / 2; i++) {
+        uint8_t hi = _hex_values[(uint8_t)hex[i * 2]];
+        uint8_t lo = _hex_values[(uint8_t)hex[i * 2 + 1]];
+        if ((hi | lo) & 0xf0) {
+            return -1;
+        }
+        buf[i] = (hi << 4) | lo;
+    }
+    return len / 2;
+}
+
+bool isHex(const char* hex, size_t len)
+{
+    if ((len & 1) != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (_hex_values[(uint8_t)hex[i]] == 0xff) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* parseInt(const char* p, const char* end, long* value)
+{
+    bool negative = false;
+    long n        = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p++ == '-';
+    }
+    const char* digits = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (p - digits == 9) {
+            return nullptr;
+        }
+        n = n * 10 + (*p++ - '0');
+    }
+    if (p == digits) {
+        return nullptr;
+    }
+    *value = negative ? -n : n;
+    return p;
+}
+
+String encodeMsg(String str)
+{
+    return bytes2hex((const uint8_t*)str.c_str(), str.length());
+}
+
+String decodeMsg(String hexEncoded)
+{
+    uint8_t chunk[32];
+    String res = "";
+    if ((hexEncoded.length() & 1) != 0 || !res.reserve(hexEncoded.length() / 2)) {
         return hexEncoded;
     }
+    for (size_t pos = 0; pos < hexEncoded.length(); pos += sizeof(chunk) * 2) {
+        size_t len = hexEncoded.length() - pos;
+        if (len > sizeof(chunk) * 2) {
+            len = sizeof(chunk) * 2;
+        }
+        int n = hex2bytes(hexEncoded.c_str() + pos, len, chunk, sizeof(chunk));
+        if (n < 0) {
+            return hexEncoded;
+        }
+        res.concat((const char*)chunk, n);
+    }
+    return res;
 }
 
 String bytes2hex(const uint8_t* buf, size_t size)
 {
+    char chunk[65];
     String res = "";
-    for (int i = 0; i < size; i++) {
-        if (buf[i] <= 0x0f) {
-            res += "0";
-        }
-        res += String(buf[i], HEX);
+    res.reserve(size * 2);
+    while (size > 0) {
+        size_t n = size > 32 ? 32 : size;
+        res.concat(chunk, bytes2hex(buf, n, chunk, sizeof(chunk)));
+        buf += n;
+        size -= n;
     }
     return res;
 }
 
 void hex2bytes(String hexEncoded, uint8_t* buf, size_t size)
 {
-    if ((hexEncoded.length() & 1) == 0) {
-        char tempbuf[((hexEncoded.length() + 1))];
-        hexEncoded.toCharArray(tempbuf, hexEncoded.length() + 1);
-        int i = 0;
-        for (int loop = 2; loop < hexEncoded.length() + 1; loop += 2) {
-            String tmpstr = hexEncoded.substring(loop - 2, loop);
-            buf[i]        = strtoul(tmpstr.c_str(), nullptr, 16);
-            i++;
-        }
-    }
+    hex2bytes(hexEncoded.c_str(), hexEncoded.length(), buf, size);
 }
 
 long hex2bin(String hex)
 {
-    if ((hex.length() & 1) == 0) {
-        char buf[hex.length() + 1];
-        hex.toCharArray(buf, hex.length() + 1);
-        long byte = 0;
-        for (int loop = 2; loop < hex.length() + 1; loop += 2) {
-            String tmpstr = hex.substring(loop - 2, loop);
-            byte          = byte << 8;
-            byte |= strtoul(tmpstr.c_str(), nullptr, 16);
-        }
-        return byte;
-    } else {
+    if ((hex.length() & 1) != 0) {
         return false;
     }
+    long byte = 0;
+    for (size_t i = 0; i < hex.length(); i++) {
+        uint8_t v = _hex_values[(uint8_t)hex[i]];
+        if (v == 0xff) {
+            return false;
+        }
+        byte = (byte << 4) | v;
+    }
+    return byte;
 }
 
 bool checkString(const String& key, size_t len)
 {
-    if (key.length() != len) {
+    return checkString(key.c_str(), len);
+}
+
+bool checkString(const char* key, size_t len)
+{
+    if (strlen(key) != len) {
         return false;
     }
-    for (char c : key) {
-        if (!isxdigit(c)) {
+    for (size_t i = 0; i < len; i++) {
+        if (_hex_values[(uint8_t)key[i]] == 0xff) {
             return false;
         }
     }
     return true;
 }
 
-bool RAK3172::init(HardwareSerial* serial, int rx, int tx, rak3172_bps_t baudRate)
+bool copyString(char* dst, size_t size, const char* src)
+{
+    int len = snprintf(dst, size, "%s", src);
+    if (len < 0 || (size_t)len >= size) {
+        dst[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+uint32_t bps2baud(rak3172_bps_t baudRate)
 {
-    int baud;
     switch (baudRate) {
-        case RAK3172_BPS_115200:
-            baud = 115200;
-            break;
         case RAK3172_BPS_9600:
-            baud = 9600;
-            break;
+            return 9600;
         case RAK3172_BPS_4800:
-            baud = 4800;
-            break;
+            return 4800;
         default:
-            baud = 115200;
-            break;
+            return 115200;
     }
-    _serial = serial;
+}
+
+#if defined RAK3172_USE_FREERTOS
+bool RAK3172::init(HardwareSerial* serial, int rx, int tx, rak3172_bps_t baudRate)
+{
     _tx_pin = tx;
     _rx_pin = rx;
-    _serial->setTimeout(200);
-    _serial->begin(baud, SERIAL_8N1, rx, tx);
-    _serial_mutex = xSemaphoreCreateMutex();
-    xSemaphoreGive(_serial_mutex);
+    _uart.begin(serial, bps2baud(baudRate), rx, tx);
+    return init(&_uart);
+}
+#endif
+
+bool RAK3172::init(RAK3172Transport* transport)
+{
+    _transport     = transport;
+    _last_result   = RAK3172_RESULT_OK;
+    _line_len      = 0;
+    _line_overflow = false;
+    _event_head    = 0;
+    _event_used    = 0;
+    _event_count   = 0;
+#if RAK3172_CACHE_SIZE > 0
+    clearCache(true);
+#endif
     return sendCommand("AT");
 }
 
-bool RAK3172::sendCommand(String cmd)
+// Copies the text after the first '=' of a response up to the next space or line end.
+static bool copyValue(const char* line, size_t len, char* value, size_t size)
 {
-    if (xSemaphoreTake(_serial_mutex, portMAX_DELAY) == pdTRUE) {
-        _serial->println(cmd);
+    const char* eq = (const char*)memchr(line, '=', len);
+    if (eq == nullptr) {
+        return false;
+    }
+    const char* p = eq + 1;
+    while (p < line + len && *p != ' ' && *p != '\n') {
+        p++;
+    }
+    len = p - eq - 1;
+    if (len >= size) {
+        len = size - 1;
+    }
+    memcpy(value, eq + 1, len);
+    value[len] = '\0';
+    return true;
+}
+
+bool parseEvent(const char* line, size_t len, rak3172_event_t* event)
+{
+    if (len < 5 || memcmp(line, "+EVT:", 5) != 0) {
+        return false;
+    }
+    const char* end  = line + len;
+    const char* name = line + 5;
+    const char* p    = name;
+    while (p < end && *p != ':' && *p != ' ' && *p != '(') {
+        p++;
+    }
+    size_t name_len  = p - name;
+    event->type      = RAK3172_EVENT_UNKNOWN;
+    event->line      = line;
+    event->len       = len;
+    event->args      = p < end ? p + 1 : end;
+    event->linkcheck = {};
+
+    size_t lo = 0;
+    size_t hi = sizeof(_event_names) / sizeof(_event_names[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp    = strncmp(_event_names[mid].name, name, name_len);
+        if (cmp == 0 && _event_names[mid].name[name_len] != '\0') {
+            cmp = 1;
+        }
+        if (cmp == 0) {
+            event->type = _event_names[mid].type;
+            break;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (event->type == RAK3172_EVENT_RXP2P && (p == end || *p != ':')) {
+        // +EVT:RXP2P RECEIVE TIMEOUT, +EVT:RXP2P RECEIVE ERROR
+        event->type = RAK3172_EVENT_RXP2P_ERROR;
+    } else if (event->type == RAK3172_EVENT_LINKCHECK) {
+        // +EVT:LINKCHECK:0:20:1:-60:8
+        long values[5]   = {};
+        const char* next = event->args;
+        for (int i = 0; i < 5 && next != nullptr && next < end; i++) {
+            next = parseInt(next, end, &values[i]);
+            if (next != nullptr && next < end && *next == ':') {
+                next++;
+            }
+        }
+        event->linkcheck.status   = values[0];
+        event->linkcheck.margin   = values[1];
+        event->linkcheck.gateways = values[2];
+        event->linkcheck.rssi     = values[3];
+        event->linkcheck.snr      = values[4];
+    }
+    return true;
+}
+
+bool RAK3172::feed(char c, rak3172_result_t* result, char* value, size_t value_size)
+{
+    if (c != '\n') {
+        if (_line_len < sizeof(_line) - 1) {
+            _line[_line_len++] = c;
+        } else {
+            _line_overflow = true;
+        }
+        return false;
+    }
+    size_t len = _line_len;
+    _line_len  = 0;
+    if (_line_overflow) {
+        _line_overflow = false;
+#if RAK3172_STATS
+        _stats.lines_dropped++;
+#endif
+        return false;
+    }
+    if (len > 0 && _line[len - 1] == '\r') {
+        len--;
+    }
+    _line[len] = '\0';
+    bool done  = false;
+    if (len >= 5 && memcmp(_line, "+EVT:", 5) == 0) {
+        queueEvent(_line, len);
+    } else if (result != nullptr) {
+#if defined RAK3172_DEBUG
+        serialPrint("RESPONSE: ");
+        serialPrintln(_line);
+#else
+#endif
+        done = matchResultLine(_line, len, result);
+        if (!done && value != nullptr && value[0] == '\0') {
+            copyValue(_line, len, value, value_size);
+        }
+    }
+    return done;
+}
+
+void RAK3172::queueEvent(const char* line, size_t len)
+{
+    // Drop the oldest lines until the new one fits.
+    while (RAK3172_EVENT_BUFFER_SIZE - _event_used < len + 2) {
+        size_t old  = _events[_event_head] | (_events[(_event_head + 1) % RAK3172_EVENT_BUFFER_SIZE] << 8);
+        _event_head = (_event_head + 2 + old) % RAK3172_EVENT_BUFFER_SIZE;
+        _event_used -= 2 + old;
+        _event_count--;
+#if RAK3172_STATS
+        _stats.events_dropped++;
+#endif
+    }
+    size_t tail                                     = (_event_head + _event_used) % RAK3172_EVENT_BUFFER_SIZE;
+    _events[tail]                                   = len & 0xFF;
+    _events[(tail + 1) % RAK3172_EVENT_BUFFER_SIZE] = len >> 8;
+
+    // The line may wrap around the end of the buffer.
+    tail         = (tail + 2) % RAK3172_EVENT_BUFFER_SIZE;
+    size_t first = len < RAK3172_EVENT_BUFFER_SIZE - tail ? len : RAK3172_EVENT_BUFFER_SIZE - tail;
+    memcpy(_events + tail, line, first);
+    memcpy(_events, line + first, len - first);
+    _event_used += 2 + len;
+    _event_count++;
+}
+
+size_t RAK3172::takeEvent(char* line)
+{
+    size_t len   = _events[_event_head] | (_events[(_event_head + 1) % RAK3172_EVENT_BUFFER_SIZE] << 8);
+    size_t start = (_event_head + 2) % RAK3172_EVENT_BUFFER_SIZE;
+    size_t first = len < RAK3172_EVENT_BUFFER_SIZE - start ? len : RAK3172_EVENT_BUFFER_SIZE - start;
+    memcpy(line, _events + start, first);
+    memcpy(line + first, _events, len - first);
+    line[len]   = '\0';
+    _event_head = (start + len) % RAK3172_EVENT_BUFFER_SIZE;
+    _event_used -= 2 + len;
+    _event_count--;
+    return len;
+}
+
+rak3172_result_t RAK3172::readResponse(char* value, size_t size, uint32_t timeout_ms, size_t* bytes_rx)
+{
+    rak3172_result_t result;
+    uint32_t start = millis();
+    uint32_t elapsed;
+    if (value != nullptr) {
+        value[0] = '\0';
+    }
+    *bytes_rx = 0;
+    while ((elapsed = millis() - start) < timeout_ms) {
+        int c = _transport->read(timeout_ms - elapsed);
+        if (c < 0) {
+            continue;
+        }
+        (*bytes_rx)++;
+        if (feed(c, &result, value, size)) {
+            return result;
+        }
+    }
+    return RAK3172_RESULT_TIMEOUT;
+}
+
+void RAK3172::processInput()
+{
+    char line[RAK3172_LINE_SIZE];
+    size_t len;
+    uint16_t count = 0;
+    if (_lock.take()) {
+        int n = _transport->available();
+        while (n-- > 0) {
+            int c = _transport->read();
+            if (c < 0) {
+                break;
+            }
+            feed(c, nullptr);
+        }
+        count = _event_count;
+        _lock.give();
+    }
+#if RAK3172_STATS
+    _stats.events += count;
+#endif
+    // Events are taken one at a time: a handler may send commands, which queue new events.
+    while (count-- > 0 && _lock.take()) {
+        if (_event_count == 0) {
+            _lock.give();
+            break;
+        }
+        len = takeEvent(line);
+        _lock.give();
+#if defined RAK3172_DEBUG
+        serialPrint("EVENT: ");
+        serialPrintln(line);
+#else
+#endif
+        rak3172_event_t event;
+        if (!parseEvent(line, len, &event)) {
+            continue;
+        }
+        handleEvent(event);
+        if (_event_cb) {
+            _event_cb(event, _event_ctx);
+        }
+    }
+    handleTimers();
+}
+
+void RAK3172::handleEvent(const rak3172_event_t& event)
+{
+}
+
+void RAK3172::handleTimers()
+{
+}
+
+bool RAK3172::onEvent(rak3172_event_cb_t callback, void* ctx)
+{
+    _event_cb  = callback;
+    _event_ctx = ctx;
+    return true;
+}
+
+bool RAK3172::sendCommand(const char* cmd, uint32_t timeout_ms)
+{
+#if RAK3172_CACHE_SIZE > 0
+    if (_diff_apply && isApplied(cmd)) {
+        _last_result = RAK3172_RESULT_OK;
+        return true;
+    }
+#endif
+    return runCommand(cmd, timeout_ms) == RAK3172_RESULT_OK;
+}
+
+bool RAK3172::sendCommand(const String& cmd, uint32_t timeout_ms)
+{
+    return sendCommand(cmd.c_str(), timeout_ms);
+}
+
+bool RAK3172::sendCommandf(const char* fmt, ...)
+{
+    char cmd[RAK3172_COMMAND_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(cmd, sizeof(cmd), fmt, args);
+    va_end(args);
+    if (len < 0 || len >= (int)sizeof(cmd)) {
+        return false;
+    }
+    return sendCommand(cmd);
+}
+
+rak3172_result_t RAK3172::runCommand(const char* cmd, uint32_t timeout_ms, const uint8_t* payload, size_t size)
+{
+    rak3172_result_t result = RAK3172_RESULT_ERROR;
+#if RAK3172_STATS
+    uint32_t wait_start = micros();
+#endif
+    if (_lock.take()) {
+#if RAK3172_STATS
+        uint32_t start    = micros();
+        size_t payload_tx = size * 2;
+#endif
+        _transport->write(cmd);
 
 #if defined RAK3172_DEBUG
         serialPrint("SEND CMD: ");
-        serialPrintln(cmd);
+        serialPrint(cmd);
 #else
 #endif
 
-        String res = _serial->readString();
+        char chunk[65];
+        while (size > 0) {
+            size_t n   = size > 32 ? 32 : size;
+            size_t len = bytes2hex(payload, n, chunk, sizeof(chunk));
+            _transport->write((const uint8_t*)chunk, len);
+#if defined RAK3172_DEBUG
+            serialPrint(chunk);
+#else
+#endif
+            payload += n;
+            size -= n;
+        }
+        _transport->write("\r\n");
 
 #if defined RAK3172_DEBUG
-        serialPrint("RESPONSE: ");
-        serialPrint(res);
+        serialPrintln();
 #else
 #endif
 
-        xSemaphoreGive(_serial_mutex);
-        if (res.indexOf("OK") != -1) {
-            return true;
+        size_t bytes_rx;
+        result       = readResponse(nullptr, 0, timeout_ms, &bytes_rx);
+        _last_result = result;
+
+#if RAK3172_STATS
+        recordCommand(cmd, start - wait_start, micros() - start, strlen(cmd) + payload_tx + 2, bytes_rx, result);
+#endif
+#if RAK3172_CACHE_SIZE > 0
+        if (_cache_enabled) {
+            updateCache(cmd, result);
         }
+#endif
+
+        _lock.give();
     }
+    return result;
+}
+
+#if defined RAK3172_USE_FREERTOS
+bool RAK3172::beginAsync(uint32_t stack_size, UBaseType_t priority, BaseType_t core)
+{
+    if (_async_task != nullptr) {
+        return true;
+    }
+    if (_async_queue == nullptr) {
+        _async_queue = xQueueCreate(RAK3172_ASYNC_QUEUE_SIZE, sizeof(rak3172_async_command_t));
+        if (_async_queue == nullptr) {
+            return false;
+        }
+    }
+    return xTaskCreatePinnedToCore(asyncTask, "RAK3172Async", stack_size, this, priority, &_async_task, core) ==
+           pdPASS;
+}
+
+void RAK3172::asyncTask(void* arg)
+{
+    RAK3172* self = (RAK3172*)arg;
+    rak3172_async_command_t item;
+    while (1) {
+        if (xQueueReceive(self->_async_queue, &item, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        rak3172_result_t result = self->runCommand(item.cmd, item.timeout_ms);
+        if (item.future) {
+            item.future->result = result;
+            __sync_synchronize();
+            item.future->done = true;
+            // Last access: the future may be released as soon as wait() returns.
+            xSemaphoreGive(item.future->signal);
+        }
+        if (item.callback) {
+            item.callback(result, item.ctx);
+        }
+    }
+}
+
+bool RAK3172::queueCommand(const char* cmd, uint32_t timeout_ms, rak3172_command_cb_t callback, void* ctx,
+                           rak3172_future_t* future)
+{
+    size_t len = strlen(cmd);
+    if (_async_queue == nullptr || len >= RAK3172_ASYNC_COMMAND_SIZE) {
+        return false;
+    }
+    rak3172_async_command_t item;
+    memcpy(item.cmd, cmd, len + 1);
+    item.timeout_ms = timeout_ms;
+    item.callback   = callback;
+    item.ctx        = ctx;
+    item.future     = future;
+    return xQueueSend(_async_queue, &item, 0) == pdTRUE;
+}
+
+bool RAK3172::sendCommandAsync(const char* cmd, rak3172_command_cb_t callback, void* ctx, uint32_t timeout_ms)
+{
+    return queueCommand(cmd, timeout_ms, callback, ctx, nullptr);
+}
+
+bool RAK3172::sendCommandAsync(const String& cmd, rak3172_command_cb_t callback, void* ctx, uint32_t timeout_ms)
+{
+    return sendCommandAsync(cmd.c_str(), callback, ctx, timeout_ms);
+}
+
+bool RAK3172::sendCommandAsync(const String& cmd, rak3172_future_t* future, uint32_t timeout_ms)
+{
+    return sendCommandAsync(cmd.c_str(), future, timeout_ms);
+}
+
+void RAK3172::failFuture(rak3172_future_t* future, rak3172_result_t result)
+{
+    future->signal = xSemaphoreCreateBinaryStatic(&future->signal_buffer);
+    future->result = result;
+    future->done   = true;
+    xSemaphoreGive(future->signal);
+}
+
+bool RAK3172::sendCommandAsync(const char* cmd, rak3172_future_t* future, uint32_t timeout_ms)
+{
+    future->done   = false;
+    future->result = RAK3172_RESULT_TIMEOUT;
+    future->signal = xSemaphoreCreateBinaryStatic(&future->signal_buffer);
+    if (queueCommand(cmd, timeout_ms, nullptr, nullptr, future)) {
+        return true;
+    }
+    failFuture(future, RAK3172_RESULT_ERROR);
     return false;
 }
 
-bool RAK3172::setBaudRate(rak3172_bps_t baudRate)
+bool RAK3172::wait(rak3172_future_t* future, uint32_t timeout_ms)
 {
-    int baud;
-    switch (baudRate) {
-        case RAK3172_BPS_115200:
-            baud = 115200;
-            break;
-        case RAK3172_BPS_9600:
-            baud = 9600;
-            break;
-        case RAK3172_BPS_4800:
-            baud = 4800;
-            break;
-        default:
-            baud = 115200;
-            break;
+    TickType_t ticks = timeout_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if (xSemaphoreTake(future->signal, ticks) != pdTRUE) {
+        return false;
+    }
+    // Keep the semaphore given, so waiting again on a completed future returns at once.
+    xSemaphoreGive(future->signal);
+    return true;
+}
+
+size_t RAK3172::pendingCommands()
+{
+    if (_async_queue == nullptr) {
+        return 0;
+    }
+    return uxQueueMessagesWaiting(_async_queue);
+}
+#endif
+
+void RAK3172::receiveLoop()
+{
+    while (_rx_running) {
+        if (_transport->waitAvailable(RECEIVE_WAIT_MS)) {
+            processInput();
+        } else {
+            handleTimers();
+        }
+    }
+}
+
+#if defined RAK3172_USE_FREERTOS
+bool RAK3172::beginReceive(uint32_t stack_size, UBaseType_t priority, BaseType_t core)
+{
+    if (_rx_task != nullptr) {
+        return true;
     }
-    bool result = sendCommand("AT+BAUD=" + String(baud));
+    _rx_running = true;
+    if (xTaskCreatePinnedToCore(receiveTask, "RAK3172Receive", stack_size, this, priority, &_rx_task, core) !=
+        pdPASS) {
+        _rx_running = false;
+        _rx_task    = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void RAK3172::receiveTask(void* arg)
+{
+    RAK3172* self = (RAK3172*)arg;
+    self->receiveLoop();
+    self->_rx_task = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void RAK3172::endReceive()
+{
+    _rx_running = false;
+    while (_rx_task != nullptr) {
+        delay(10);
+    }
+}
+#else
+bool RAK3172::beginReceive(size_t stack_size)
+{
+    pthread_attr_t attr;
+    if (_rx_started) {
+        return true;
+    }
+    pthread_attr_init(&attr);
+    if (stack_size > 0) {
+        pthread_attr_setstacksize(&attr, stack_size);
+    }
+    _rx_running = true;
+    _rx_started = pthread_create(&_rx_thread, &attr, receiveTask, this) == 0;
+    _rx_running = _rx_started;
+    pthread_attr_destroy(&attr);
+    return _rx_started;
+}
+
+void* RAK3172::receiveTask(void* arg)
+{
+    ((RAK3172*)arg)->receiveLoop();
+    return nullptr;
+}
+
+void RAK3172::endReceive()
+{
+    _rx_running = false;
+    if (_rx_started) {
+        pthread_join(_rx_thread, nullptr);
+        _rx_started = false;
+    }
+}
+#endif
+
+bool RAK3172::setBaudRate(rak3172_bps_t baudRate)
+{
+    uint32_t baud = bps2baud(baudRate);
+    bool result   = sendCommandf("AT+BAUD=%lu", (unsigned long)baud);
     if (result) {
-        _serial->updateBaudRate(baud);
+        _transport->setBaudRate(baud);
+#if RAK3172_CACHE_SIZE > 0
+        invalidateCache();
+#endif
     }
     return result;
 }
@@ -182,7 +889,7 @@ bool RAK3172::setLPM(bool enable)
 
 bool RAK3172::setLPMLevel(rak3172_sleep_t level)
 {
-    return sendCommand("AT+LPMLVL=" + String(level));
+    return sendCommandf("AT+LPMLVL=%d", level);
 }
 
 bool RAK3172::sleep(uint32_t time_ms)
@@ -190,47 +897,508 @@ bool RAK3172::sleep(uint32_t time_ms)
     if (time_ms == 0) {
         return sendCommand("AT+SLEEP");
     }
-    return sendCommand("AT+SLEEP=" + String(time_ms));
+    return sendCommandf("AT+SLEEP=%lu", (unsigned long)time_ms);
+}
+
+bool RAK3172::setDeviceAlias(const char* alias)
+{
+    return sendCommandf("AT+ALIAS=%s", alias);
+}
+
+bool RAK3172::setDeviceAlias(const String& alias)
+{
+    return setDeviceAlias(alias.c_str());
+}
+
+#if RAK3172_STATS
+void RAK3172::recordCommand(const char* cmd, uint32_t lock_wait_us, uint32_t latency_us, size_t bytes_tx,
+                            size_t bytes_rx, rak3172_result_t result)
+{
+    char verb[sizeof(_stats.verbs[0].verb)];
+    const char* name = strncmp(cmd, "AT+", 3) == 0 ? cmd + 3 : cmd;
+    size_t len       = strcspn(name, "=?:");
+    if (len > sizeof(verb) - 2) {
+        len = sizeof(verb) - 2;
+    }
+    memcpy(verb, name, len);
+    if (name[len] == '?' || strncmp(name + len, "=?", 3) == 0) {
+        verb[len++] = '?';
+    }
+    verb[len] = '\0';
+
+    _stats.lock_wait_sum_us += lock_wait_us;
+    if (lock_wait_us > _stats.lock_wait_max_us) {
+        _stats.lock_wait_max_us = lock_wait_us;
+    }
+
+    rak3172_verb_stats_t* entry = nullptr;
+    for (uint8_t i = 0; i < _stats.verb_count; i++) {
+        if (strcmp(_stats.verbs[i].verb, verb) == 0) {
+            entry = &_stats.verbs[i];
+            break;
+        }
+    }
+    if (entry == nullptr) {
+        if (_stats.verb_count == RAK3172_STATS_VERBS) {
+            _stats.verbs_untracked++;
+            return;
+        }
+        entry = &_stats.verbs[_stats.verb_count++];
+        memcpy(entry->verb, verb, len + 1);
+    }
+
+    uint32_t latency_ms = latency_us / 1000;
+    uint8_t bucket      = latency_ms == 0 ? 0 : 32 - __builtin_clz(latency_ms);
+    if (bucket >= RAK3172_STATS_BUCKETS) {
+        bucket = RAK3172_STATS_BUCKETS - 1;
+    }
+    entry->count++;
+    entry->bytes_tx += bytes_tx;
+    entry->bytes_rx += bytes_rx;
+    entry->latency_sum_us += latency_us;
+    entry->latency_hist[bucket]++;
+    if (latency_us > entry->latency_max_us) {
+        entry->latency_max_us = latency_us;
+    }
+    if (result == RAK3172_RESULT_TIMEOUT) {
+        entry->timeouts++;
+    } else if (result != RAK3172_RESULT_OK) {
+        entry->errors++;
+    }
+}
+
+void RAK3172::getStats(rak3172_stats_t* stats)
+{
+    if (_lock.take()) {
+        *stats = _stats;
+        _lock.give();
+    }
+}
+
+void RAK3172::resetStats()
+{
+    if (_lock.take()) {
+        _stats = {};
+        _lock.give();
+    }
+}
+#endif
+
+#if RAK3172_CACHE_SIZE > 0
+rak3172_cache_entry_t* RAK3172::findCache(const char* verb)
+{
+    for (size_t i = 0; i < RAK3172_CACHE_SIZE; i++) {
+        if (_cache[i].verb[0] != '\0' && strcmp(_cache[i].verb, verb) == 0) {
+            return &_cache[i];
+        }
+    }
+    return nullptr;
+}
+
+void RAK3172::storeCache(const char* verb, const char* value, size_t len)
+{
+    rak3172_cache_entry_t* entry = findCache(verb);
+    if (len >= sizeof(entry->value) || strlen(verb) >= sizeof(entry->verb)) {
+        if (entry != nullptr) {
+            entry->verb[0] = '\0';
+        }
+        return;
+    }
+    for (size_t i = 0; entry == nullptr && i < RAK3172_CACHE_SIZE; i++) {
+        if (_cache[i].verb[0] == '\0') {
+            entry = &_cache[i];
+        }
+    }
+    if (entry == nullptr) {
+        entry       = &_cache[_cache_next];
+        _cache_next = (_cache_next + 1) % RAK3172_CACHE_SIZE;
+    }
+    strcpy(entry->verb, verb);
+    memcpy(entry->value, value, len);
+    entry->value[len] = '\0';
+}
+
+void RAK3172::clearCache(bool all)
+{
+    for (size_t i = 0; i < RAK3172_CACHE_SIZE; i++) {
+        if (all || !isImmutable(_cache[i].verb)) {
+            _cache[i].verb[0] = '\0';
+        }
+    }
+}
+
+void RAK3172::updateCache(const char* cmd, rak3172_result_t result)
+{
+    char verb[sizeof(_cache[0].verb)];
+    const char* value;
+    if (strcmp(cmd, "ATZ") == 0 || strcmp(cmd, "ATR") == 0) {
+        // The module restarts (ATZ) or restores its defaults (ATR) even if no OK makes it back.
+        clearCache(false);
+        return;
+    }
+    if (result != RAK3172_RESULT_OK || !splitCommand(cmd, verb, sizeof(verb), &value) || value == nullptr ||
+        isUncached(verb)) {
+        return;
+    }
+    if (inList(verb, _cache_coupled, sizeof(_cache_coupled) / sizeof(_cache_coupled[0]))) {
+        clearCache(false);
+    }
+    storeCache(verb, value, strlen(value));
+}
+
+void RAK3172::enableCache(bool enable)
+{
+    if (_lock.take()) {
+        _cache_enabled = enable;
+        if (!enable) {
+            _diff_apply = false;
+            clearCache(true);
+        }
+        _lock.give();
+    }
+}
+
+void RAK3172::invalidateCache()
+{
+    if (_lock.take()) {
+        clearCache(false);
+        _lock.give();
+    }
+}
+
+void RAK3172::invalidateCache(const char* verb)
+{
+    if (_lock.take()) {
+        rak3172_cache_entry_t* entry = findCache(verb);
+        if (entry != nullptr) {
+            entry->verb[0] = '\0';
+        }
+        _lock.give();
+    }
+}
+
+void RAK3172::invalidateNetworkCache()
+{
+    if (_lock.take()) {
+        for (size_t i = 0; i < sizeof(_cache_network) / sizeof(_cache_network[0]); i++) {
+            rak3172_cache_entry_t* entry = findCache(_cache_network[i]);
+            if (entry != nullptr) {
+                entry->verb[0] = '\0';
+            }
+        }
+        _lock.give();
+    }
+}
+
+bool RAK3172::refreshCache()
+{
+    char verbs[RAK3172_CACHE_SIZE][sizeof(_cache[0].verb)];
+    char cmd[sizeof(_cache[0].verb) + 8];
+    char value[sizeof(_cache[0].value)];
+    rak3172_result_t result;
+    size_t count = 0;
+    bool ok      = true;
+    if (!_lock.take()) {
+        return false;
+    }
+    for (size_t i = 0; i < RAK3172_CACHE_SIZE; i++) {
+        if (_cache[i].verb[0] != '\0' && !isImmutable(_cache[i].verb)) {
+            strcpy(verbs[count++], _cache[i].verb);
+            _cache[i].verb[0] = '\0';
+        }
+    }
+    _lock.give();
+    for (size_t i = 0; i < count; i++) {
+        snprintf(cmd, sizeof(cmd), "AT+%s=?", verbs[i]);
+        getCommand(cmd, value, sizeof(value), RAK3172_COMMAND_TIMEOUT, &result);
+        ok = ok && result == RAK3172_RESULT_OK;
+    }
+    return ok;
+}
+
+rak3172_cache_entry_t* RAK3172::cachedQuery(const char* cmd, char* verb, size_t verb_size)
+{
+    const char* value;
+    if (!_cache_enabled || !splitCommand(cmd, verb, verb_size, &value) || value != nullptr || isUncached(verb)) {
+        verb[0] = '\0';
+        return nullptr;
+    }
+    return findCache(verb);
+}
+
+bool RAK3172::isApplied(const char* cmd)
+{
+    char verb[sizeof(_cache[0].verb)];
+    char query[sizeof(_cache[0].verb) + 8];
+    char current[sizeof(_cache[0].value)];
+    rak3172_result_t result;
+    const char* value;
+    if (!splitCommand(cmd, verb, sizeof(verb), &value) || value == nullptr || isUncached(verb)) {
+        return false;
+    }
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (attempt > 0) {
+            // Not known yet: read it once, getCommand() stores the answer.
+            snprintf(query, sizeof(query), "AT+%s=?", verb);
+            getCommand(query, current, sizeof(current), RAK3172_COMMAND_TIMEOUT, &result);
+            if (result != RAK3172_RESULT_OK) {
+                return false;
+            }
+        }
+        if (!_lock.take()) {
+            return false;
+        }
+        rak3172_cache_entry_t* entry = findCache(verb);
+        bool known                   = entry != nullptr;
+        bool applied                 = known && strcasecmp(entry->value, value) == 0;
+#if RAK3172_STATS
+        if (applied) {
+            _stats.commands_skipped++;
+        }
+#endif
+        _lock.give();
+        if (known) {
+            return applied;
+        }
+    }
+    return false;
 }
 
-bool RAK3172::setDeviceAlias(String alias)
+void RAK3172::enableDiffApply(bool enable)
 {
-    return sendCommand("AT+ALIAS=" + alias);
+    if (_lock.take()) {
+        _diff_apply = enable;
+        if (enable) {
+            _cache_enabled = true;
+        }
+        _lock.give();
+    }
 }
 
-String RAK3172::getCommand(String cmd)
+size_t RAK3172::saveCache(rak3172_cache_entry_t* entries, size_t count)
 {
-    String data = "";
-    if (xSemaphoreTake(_serial_mutex, portMAX_DELAY) == pdTRUE) {
-        _serial->println(cmd);
+    size_t n = 0;
+    if (_lock.take()) {
+        for (size_t i = 0; i < RAK3172_CACHE_SIZE && n < count; i++) {
+            if (_cache[i].verb[0] != '\0') {
+                entries[n++] = _cache[i];
+            }
+        }
+        _lock.give();
+    }
+    return n;
+}
+
+void RAK3172::restoreCache(const rak3172_cache_entry_t* entries, size_t count)
+{
+    if (_lock.take()) {
+        for (size_t i = 0; i < count; i++) {
+            const rak3172_cache_entry_t* entry = &entries[i];
+            if (entry->verb[0] != '\0' && memchr(entry->verb, '\0', sizeof(entry->verb)) != nullptr &&
+                memchr(entry->value, '\0', sizeof(entry->value)) != nullptr) {
+                storeCache(entry->verb, entry->value, strlen(entry->value));
+            }
+        }
+        _lock.give();
+    }
+}
+#endif
+
+rak3172_result_t RAK3172::getLastResult()
+{
+    return _last_result;
+}
+
+String RAK3172::getCommand(const String& cmd, uint32_t timeout_ms)
+{
+    return getCommand(cmd.c_str(), timeout_ms);
+}
+
+String RAK3172::getCommand(const char* cmd, uint32_t timeout_ms)
+{
+    char value[RAK3172_LINE_SIZE];
+    getCommand(cmd, value, sizeof(value), timeout_ms);
+    return String(value);
+}
+
+bool RAK3172::getCommand(const char* cmd, char* value, size_t size, uint32_t timeout_ms, rak3172_result_t* result)
+{
+    rak3172_result_t res = RAK3172_RESULT_TIMEOUT;
+    if (size == 0) {
+        if (result != nullptr) {
+            *result = RAK3172_RESULT_PARAM_OVERFLOW;
+        }
+        return false;
+    }
+    value[0] = '\0';
+#if RAK3172_STATS
+    uint32_t wait_start = micros();
+#endif
+    if (_lock.take()) {
+#if RAK3172_CACHE_SIZE > 0
+        char verb[sizeof(_cache[0].verb)];
+        rak3172_cache_entry_t* entry = cachedQuery(cmd, verb, sizeof(verb));
+        if (entry != nullptr) {
+            snprintf(value, size, "%s", entry->value);
+            _last_result = RAK3172_RESULT_OK;
+            _lock.give();
+            if (result != nullptr) {
+                *result = RAK3172_RESULT_OK;
+            }
+            return value[0] != '\0';
+        }
+#endif
+#if RAK3172_STATS
+        uint32_t start = micros();
+#endif
+        _transport->write(cmd);
+        _transport->write("\r\n");
 
 #if defined RAK3172_DEBUG
-        Serial.print("SEND CMD: ");
-        Serial.println(cmd);
+        serialPrint("SEND CMD: ");
+        serialPrintln(cmd);
 #else
 #endif
 
-        String res = _serial->readString();
+        size_t bytes_rx;
+        res          = readResponse(value, size, timeout_ms, &bytes_rx);
+        _last_result = res;
 
 #if defined RAK3172_DEBUG
-        serialPrint("RESPONSE: ");
-        serialPrintln(res);
+        serialPrint("VALUE: ");
+        serialPrintln(value);
 #else
 #endif
-        xSemaphoreGive(_serial_mutex);
-        int index = res.indexOf('=');
-        if (index != -1) {
-            int endIndex = res.indexOf(' ', index);
-            if (endIndex == -1) {
-                endIndex = res.indexOf('\n', index);
-                if (endIndex == -1) {
-                    endIndex = res.length();
-                }
+#if RAK3172_STATS
+        recordCommand(cmd, start - wait_start, micros() - start, strlen(cmd) + 2, bytes_rx, res);
+#endif
+#if RAK3172_CACHE_SIZE > 0
+        if (verb[0] != '\0' && res == RAK3172_RESULT_OK) {
+            storeCache(verb, value, strlen(value));
+        }
+#endif
+        _lock.give();
+    }
+    if (result != nullptr) {
+        *result = res;
+    }
+    return res == RAK3172_RESULT_OK && value[0] != '\0';
+}
+
+bool RAK3172::getNumber(const char* cmd, uint32_t* number)
+{
+    char value[16];
+    char* end;
+    if (!getCommand(cmd, value, sizeof(value))) {
+        return false;
+    }
+    unsigned long n = strtoul(value, &end, 10);
+    if (*end != '\0' || value[0] == '-') {
+        return false;
+    }
+    *number = n;
+    return true;
+}
+
+bool RAK3172::getBytes(const char* cmd, uint8_t* buf, size_t size)
+{
+    char value[2 * 16 + 2];
+    if (size > 16 || !getCommand(cmd, value, sizeof(value))) {
+        return false;
+    }
+    return hex2bytes(value, strlen(value), buf, size) == (int)size;
+}
+
+size_t RAK3172::getCommands(const char* const* cmds, size_t count, char* values, size_t value_size,
+                            uint32_t timeout_ms, rak3172_result_t* result)
+{
+    size_t inflight[RAK3172_PIPELINE_DEPTH];
+#if RAK3172_STATS
+    uint32_t sent_us[RAK3172_PIPELINE_DEPTH];
+#endif
+    size_t head     = 0;
+    size_t pending  = 0;
+    size_t next     = 0;
+    size_t answered = 0;
+    if (result != nullptr) {
+        *result = RAK3172_RESULT_ERROR;
+    }
+    if (value_size == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        values[i * value_size] = '\0';
+    }
+    if (!_lock.take()) {
+        return 0;
+    }
+    if (result != nullptr) {
+        *result = RAK3172_RESULT_OK;
+    }
+    while (next < count || pending > 0) {
+        while (next < count && pending < RAK3172_PIPELINE_DEPTH) {
+            size_t i = next++;
+#if RAK3172_CACHE_SIZE > 0
+            char verb[sizeof(_cache[0].verb)];
+            rak3172_cache_entry_t* entry = cachedQuery(cmds[i], verb, sizeof(verb));
+            if (entry != nullptr) {
+                snprintf(values + i * value_size, value_size, "%s", entry->value);
+                answered++;
+                continue;
+            }
+#endif
+            _transport->write(cmds[i]);
+            _transport->write("\r\n");
+#if defined RAK3172_DEBUG
+            serialPrint("SEND CMD: ");
+            serialPrintln(cmds[i]);
+#else
+#endif
+            size_t slot    = (head + pending) % RAK3172_PIPELINE_DEPTH;
+            inflight[slot] = i;
+#if RAK3172_STATS
+            sent_us[slot] = micros();
+#endif
+            pending++;
+        }
+        if (pending == 0) {
+            break;
+        }
+        size_t slot = head;
+        size_t i    = inflight[slot];
+        head        = (head + 1) % RAK3172_PIPELINE_DEPTH;
+        pending--;
+
+        size_t bytes_rx;
+        char* value  = values + i * value_size;
+        _last_result = readResponse(value, value_size, timeout_ms, &bytes_rx);
+        if (result != nullptr) {
+            *result = _last_result;
+        }
+
+#if RAK3172_STATS
+        recordCommand(cmds[i], 0, micros() - sent_us[slot], strlen(cmds[i]) + 2, bytes_rx, _last_result);
+#endif
+        if (_last_result != RAK3172_RESULT_OK) {
+            value[0] = '\0';
+        }
+        if (_last_result == RAK3172_RESULT_TIMEOUT) {
+            // Responses still on their way can no longer be matched to their queries.
+            break;
+        }
+        if (value[0] != '\0') {
+            answered++;
+#if RAK3172_CACHE_SIZE > 0
+            char verb[sizeof(_cache[0].verb)];
+            cachedQuery(cmds[i], verb, sizeof(verb));
+            if (verb[0] != '\0') {
+                storeCache(verb, values + i * value_size, strlen(values + i * value_size));
             }
-            data = res.substring(index + 1, endIndex);
+#endif
         }
     }
-    return data;
+    _lock.give();
+    return answered;
 }
 
 String RAK3172::getVersion()
@@ -248,6 +1416,16 @@ String RAK3172::getBaudRate()
     return getCommand("AT+BAUD=?");
 }
 
+bool RAK3172::getBaudRate(uint32_t& baud)
+{
+    uint32_t value;
+    if (!getNumber("AT+BAUD=?", &value)) {
+        return false;
+    }
+    baud = value;
+    return true;
+}
+
 String RAK3172::getBAT()
 {
     return getCommand("AT+BAT=?");
@@ -8,6 +8,7 @@
 #define _RAK3172_COMMON_HPP_
 
 #include <Arduino.h>
+#include "rak3172_transport.hpp"
 
 // #define RAK3172_DEBUG Serial  // This macro definition can be annotated without sending and receiving data prints
 //          Define the serial port you want to use, e.g., Serial1 or Serial2
@@ -19,6 +20,138 @@
 #else
 #endif
 
+/**
+ * @def RAK3172_COMMAND_TIMEOUT
+ * @brief Hard upper bound (ms) on the wait for the final result line of an AT command.
+ *
+ * The response reader returns as soon as a final result line (e.g. `OK`, `AT_ERROR`) arrives;
+ * this timeout only applies when the module does not answer at all.
+ */
+#ifndef RAK3172_COMMAND_TIMEOUT
+#define RAK3172_COMMAND_TIMEOUT 1000
+#endif
+
+/**
+ * @def RAK3172_LINE_SIZE
+ * @brief Size (including the terminator) of the buffer assembling one received line.
+ *
+ * Large enough for a `+EVT:RX_` or `+EVT:RXP2P:` line carrying the largest payload in
+ * hexadecimal. Longer lines are discarded as a whole instead of being parsed truncated.
+ * Costs this many bytes in every driver object, and as much stack in `update()`.
+ */
+#ifndef RAK3172_LINE_SIZE
+#define RAK3172_LINE_SIZE 600
+#endif
+
+/**
+ * @def RAK3172_EVENT_BUFFER_SIZE
+ * @brief Size in bytes of the buffer keeping unsolicited `+EVT:` lines between two `update()` calls.
+ *
+ * Event lines received while a command is waiting for its response are kept here
+ * until the next `update()` hands them to the event parser. Each line takes its length
+ * plus 2 bytes, so the default holds two lines carrying the largest payload or dozens
+ * of short events such as `+EVT:TX_DONE`. When the buffer is full the oldest lines are
+ * dropped. Costs this many bytes in every driver object; must be at least
+ * `RAK3172_LINE_SIZE + 2`.
+ */
+#ifndef RAK3172_EVENT_BUFFER_SIZE
+#define RAK3172_EVENT_BUFFER_SIZE 1280
+#endif
+
+#if RAK3172_EVENT_BUFFER_SIZE < RAK3172_LINE_SIZE + 2
+#error "M5-LoRaWAN-RAK: RAK3172_EVENT_BUFFER_SIZE must hold one line of RAK3172_LINE_SIZE"
+#endif
+
+/**
+ * @def RAK3172_COMMAND_SIZE
+ * @brief Size (including the terminator) of the stack buffer used to format setter commands.
+ *
+ * Large enough for the longest fixed-format command (`AT+ADDMULC`); payload commands
+ * such as `AT+SEND` do not go through this buffer.
+ */
+#ifndef RAK3172_COMMAND_SIZE
+#define RAK3172_COMMAND_SIZE 128
+#endif
+
+/**
+ * @def RAK3172_ASYNC_QUEUE_SIZE
+ * @brief Number of commands that can be waiting in the asynchronous command queue.
+ */
+#ifndef RAK3172_ASYNC_QUEUE_SIZE
+#define RAK3172_ASYNC_QUEUE_SIZE 8
+#endif
+
+/**
+ * @def RAK3172_ASYNC_COMMAND_SIZE
+ * @brief Maximum length (including the terminator) of a command in the asynchronous queue.
+ *
+ * The default fits `AT+SEND` with a 242-byte payload.
+ */
+#ifndef RAK3172_ASYNC_COMMAND_SIZE
+#define RAK3172_ASYNC_COMMAND_SIZE 512
+#endif
+
+/**
+ * @def RAK3172_PIPELINE_DEPTH
+ * @brief Number of queries `RAK3172::getCommands()` keeps in flight at once.
+ *
+ * The module answers commands one after the other and holds the following ones in its
+ * UART receive buffer, so the commands in flight must stay well below that buffer size.
+ */
+#ifndef RAK3172_PIPELINE_DEPTH
+#define RAK3172_PIPELINE_DEPTH 4
+#endif
+
+/**
+ * @def RAK3172_STATS
+ * @brief Enables the command and event counters returned by `RAK3172::getStats()` (1 by default).
+ *
+ * The counters cost `RAK3172_STATS_VERBS * (48 + 4 * RAK3172_STATS_BUCKETS)` bytes (2.7 KB
+ * by default) in every driver object. Define it to 0 to compile the instrumentation out
+ * completely.
+ */
+#ifndef RAK3172_STATS
+#define RAK3172_STATS 1
+#endif
+
+/**
+ * @def RAK3172_STATS_VERBS
+ * @brief Number of distinct command verbs tracked by the statistics.
+ */
+#ifndef RAK3172_STATS_VERBS
+#define RAK3172_STATS_VERBS 24
+#endif
+
+/**
+ * @def RAK3172_STATS_BUCKETS
+ * @brief Number of log2 buckets of the latency histograms.
+ *
+ * Bucket 0 counts round trips below 1 ms, bucket `i` those in [2^(i-1), 2^i) ms; the last
+ * bucket also counts everything above.
+ */
+#ifndef RAK3172_STATS_BUCKETS
+#define RAK3172_STATS_BUCKETS 16
+#endif
+
+/**
+ * @def RAK3172_CACHE_SIZE
+ * @brief Number of parameter values kept by the shadow cache, see `RAK3172::enableCache()`.
+ *
+ * Each entry costs `16 + RAK3172_CACHE_VALUE_SIZE` bytes (1.5 KB in total by default) in
+ * every driver object. Define it to 0 to compile the cache out completely.
+ */
+#ifndef RAK3172_CACHE_SIZE
+#define RAK3172_CACHE_SIZE 24
+#endif
+
+/**
+ * @def RAK3172_CACHE_VALUE_SIZE
+ * @brief Size (including the terminator) of a value in the shadow cache; longer values are not cached.
+ */
+#ifndef RAK3172_CACHE_VALUE_SIZE
+#define RAK3172_CACHE_VALUE_SIZE 48
+#endif
+
 typedef enum {
     RAK3172_BPS_115200 = 0, /**< Baud rate of 115200 bps */
     RAK3172_BPS_9600,       /**< Baud rate of 9600 bps */
@@ -30,6 +163,139 @@ typedef enum {
     RAK3172_SLEEP_TWO,     /**< Low power mode level 2 */
 } rak3172_sleep_t;
 
+typedef enum {
+    RAK3172_RESULT_OK = 0,            /**< Command accepted (`OK`) */
+    RAK3172_RESULT_ERROR,             /**< Generic error (`AT_ERROR`) */
+    RAK3172_RESULT_PARAM_ERROR,       /**< Invalid parameter (`AT_PARAM_ERROR`) */
+    RAK3172_RESULT_BUSY_ERROR,        /**< Module busy (`AT_BUSY_ERROR`) */
+    RAK3172_RESULT_PARAM_OVERFLOW,    /**< Parameter too long (`AT_TEST_PARAM_OVERFLOW`) */
+    RAK3172_RESULT_NO_CLASSB_ENABLE,  /**< Class B not enabled (`AT_NO_CLASSB_ENABLE`) */
+    RAK3172_RESULT_NO_NETWORK_JOINED, /**< Network not joined (`AT_NO_NETWORK_JOINED`) */
+    RAK3172_RESULT_RX_ERROR,          /**< Reception error (`AT_RX_ERROR`) */
+    RAK3172_RESULT_MODE_NO_SUPPORT,   /**< Not supported in the current mode (`AT_MODE_NO_SUPPORT`) */
+    RAK3172_RESULT_COMMAND_NOT_FOUND, /**< Unknown command (`AT_COMMAND_NOT_FOUND`) */
+    RAK3172_RESULT_TIMEOUT,           /**< No final result line before the timeout expired */
+} rak3172_result_t;
+
+/**
+ * @brief Completion callback of an asynchronous command.
+ *
+ * Called from the asynchronous worker task once the module answered the command.
+ *
+ * @param result The final result of the command.
+ * @param ctx The user context pointer passed when the command was queued.
+ */
+typedef void (*rak3172_command_cb_t)(rak3172_result_t result, void* ctx);
+
+/**
+ * @brief Unsolicited events reported by the module with a `+EVT:` line.
+ */
+typedef enum {
+    RAK3172_EVENT_UNKNOWN = 0,           /**< Any other `+EVT:` line */
+    RAK3172_EVENT_JOINED,                /**< LoRaWAN network joined (`+EVT:JOINED`) */
+    RAK3172_EVENT_JOIN_FAILED,           /**< LoRaWAN join failed (`+EVT:JOIN_FAILED...`) */
+    RAK3172_EVENT_TX_DONE,               /**< LoRaWAN uplink sent (`+EVT:TX_DONE`) */
+    RAK3172_EVENT_SEND_CONFIRMED_OK,     /**< Confirmed uplink acknowledged (`+EVT:SEND_CONFIRMED_OK`) */
+    RAK3172_EVENT_SEND_CONFIRMED_FAILED, /**< Confirmed uplink not acknowledged (`+EVT:SEND_CONFIRMED_FAILED...`) */
+    RAK3172_EVENT_LINKCHECK,             /**< Link check answer (`+EVT:LINKCHECK:...`) */
+    RAK3172_EVENT_RX,                    /**< LoRaWAN downlink (`+EVT:RX_1`, `RX_2`, `RX_B`, `RX_C`) */
+    RAK3172_EVENT_TXP2P_DONE,            /**< P2P packet sent (`+EVT:TXP2P DONE`) */
+    RAK3172_EVENT_RXP2P,                 /**< P2P packet received (`+EVT:RXP2P:...`) */
+    RAK3172_EVENT_RXP2P_ERROR,           /**< P2P reception failed (`+EVT:RXP2P RECEIVE ...`) */
+} rak3172_event_type_t;
+
+/**
+ * @brief Result of a LoRaWAN link check (`+EVT:LINKCHECK:<status>:<margin>:<gateways>:<rssi>:<snr>`).
+ */
+typedef struct {
+    uint8_t status;   /**< 0 if the network answered the link check request */
+    uint8_t margin;   /**< Demodulation margin in dB */
+    uint8_t gateways; /**< Number of gateways that received the request */
+    int16_t rssi;     /**< RSSI of the answer in dBm */
+    int8_t snr;       /**< SNR of the answer in dB */
+} rak3172_linkcheck_t;
+
+/**
+ * @brief An unsolicited event, see `parseEvent()`.
+ */
+typedef struct {
+    rak3172_event_type_t type;     /**< The event type */
+    const char* line;              /**< The whole event line, e.g. `+EVT:RX_1:-40:8:UNICAST:2:cafe` */
+    size_t len;                    /**< The length of `line` */
+    const char* args;              /**< The text after the event name and its separator, within `line` */
+    rak3172_linkcheck_t linkcheck; /**< The link check result, for `RAK3172_EVENT_LINKCHECK` */
+} rak3172_event_t;
+
+/**
+ * @brief Callback receiving every unsolicited event, see `RAK3172::onEvent()`.
+ *
+ * @param event The event. Its strings are only valid during the call.
+ * @param ctx The user pointer passed to `onEvent()`.
+ */
+typedef void (*rak3172_event_cb_t)(const rak3172_event_t& event, void* ctx);
+
+/**
+ * @brief Completion state of an asynchronous command.
+ *
+ * The structure is owned by the caller. The worker task still gives `signal` after setting
+ * `done`, so the structure must stay valid until `RAK3172::wait()` returned `true`.
+ */
+typedef struct {
+    volatile bool done;               /**< Set by the worker task once the command completed */
+    volatile rak3172_result_t result; /**< Final result of the command, valid once `done` is set */
+#if defined RAK3172_USE_FREERTOS
+    SemaphoreHandle_t signal;         /**< Given once `done` is set, taken by `RAK3172::wait()` */
+    StaticSemaphore_t signal_buffer;  /**< Storage of `signal`, so no heap is used per command */
+#endif
+} rak3172_future_t;
+
+#if RAK3172_STATS
+/**
+ * @brief Counters of one command verb.
+ *
+ * The verb is the command name without `AT+` and arguments; queries get a trailing `?`,
+ * e.g. `AT+DR=3` is counted as `DR` and `AT+DR=?` as `DR?`.
+ */
+typedef struct {
+    char verb[16];                                /**< Command verb, e.g. `SEND` or `VER?` */
+    uint32_t count;                               /**< Number of commands sent */
+    uint32_t timeouts;                            /**< Commands without a final result line */
+    uint32_t errors;                              /**< Commands answered with an error result */
+    uint32_t bytes_tx;                            /**< Bytes written, including CR LF */
+    uint32_t bytes_rx;                            /**< Response bytes read */
+    uint32_t latency_max_us;                      /**< Longest round trip in microseconds */
+    uint64_t latency_sum_us;                      /**< Sum of all round trips in microseconds */
+    uint32_t latency_hist[RAK3172_STATS_BUCKETS]; /**< Round trips per log2 millisecond bucket */
+} rak3172_verb_stats_t;
+
+/**
+ * @brief Snapshot of the driver statistics, see `RAK3172::getStats()`.
+ */
+typedef struct {
+    rak3172_verb_stats_t verbs[RAK3172_STATS_VERBS]; /**< Per-verb counters */
+    uint8_t verb_count;                              /**< Number of used entries in `verbs` */
+    uint32_t verbs_untracked;                        /**< Commands whose verb did not fit in `verbs` */
+    uint32_t lock_wait_max_us;                       /**< Longest wait for the serial lock */
+    uint64_t lock_wait_sum_us;                       /**< Total time spent waiting for the serial lock */
+    uint32_t events;                                 /**< `+EVT:` lines handed to `handleEvent()` */
+    uint32_t events_dropped;                         /**< `+EVT:` lines lost because the event buffer was full */
+    uint32_t lines_dropped;                          /**< Lines longer than `RAK3172_LINE_SIZE`, discarded */
+    uint32_t frames_parsed;                          /**< Received frames stored in the frame queue */
+    uint32_t frames_dropped;                         /**< Received frames discarded by the frame queue */
+    uint32_t commands_skipped;                       /**< Setters skipped because the value was already set */
+} rak3172_stats_t;
+#endif
+
+#if RAK3172_CACHE_SIZE > 0
+/**
+ * @brief One value of the shadow cache, see `RAK3172::enableCache()`.
+ */
+typedef struct {
+    char verb[16];                        /**< Parameter name without `AT+`, empty for a free entry */
+    char value[RAK3172_CACHE_VALUE_SIZE]; /**< Last value read from or written to the module */
+} rak3172_cache_entry_t;
+#endif
+
 /**
  * @brief Encodes a given string into its hexadecimal representation.
  *
@@ -38,9 +304,8 @@ typedef enum {
  *
  * @note
  * - The input string should not be empty.
- * - The function allocates a temporary buffer for the encoded string, which may
- *   lead to stack overflow if the input string is too long.
- * - Ensure that the resulting string is properly managed to avoid memory leaks.
+ * - Use `bytes2hex(const uint8_t*, size_t, char*, size_t)` to encode into a caller
+ *   buffer without allocating a `String`.
  *
  * @param str The input string to be encoded.
  * @return A String object containing the hexadecimal representation of the input string.
@@ -52,18 +317,19 @@ String encodeMsg(String str);
  * @brief Decodes a hexadecimal encoded string back to its original representation.
  *
  * This function takes a hexadecimal encoded string and converts it back to
- * the original string. If the input string's length is not even, it returns
- * the input string unchanged.
+ * the original string. If the input string's length is not even, or it contains
+ * characters that are not hexadecimal digits, it returns the input string unchanged.
  *
  * @note
  * - The input string should be a valid hexadecimal representation (even-length).
  * - If the input string has an odd length, it will be returned as is without
  *   any decoding.
- * - Ensure that the resulting string is properly managed to avoid memory leaks.
+ * - Decoding is binary-safe: 0x00 bytes are kept, so use `length()` rather than
+ *   `strlen()` on the result.
  *
  * @param hexEncoded The hexadecimal encoded string to be decoded.
  * @return A String object containing the original representation of the input
- *         hexadecimal string, or the input string if its length is odd.
+ *         hexadecimal string, or the input string if it is not valid hexadecimal.
  */
 String decodeMsg(String hexEncoded);
 
@@ -84,6 +350,20 @@ String decodeMsg(String hexEncoded);
  */
 String bytes2hex(const uint8_t* buf, size_t size);
 
+/**
+ * @brief Converts a byte array to lowercase hexadecimal into a caller-provided buffer.
+ *
+ * Each byte is translated with a single table lookup; no heap memory is used.
+ *
+ * @param buf Pointer to the byte array to be converted.
+ * @param size The number of bytes in the array.
+ * @param hex Destination buffer for the hexadecimal characters and the terminating '\0'.
+ * @param hex_size The size of the destination buffer, at least `2 * size + 1`.
+ * @return The number of hexadecimal characters written (`2 * size`), or 0 if the
+ *         destination buffer is too small.
+ */
+size_t bytes2hex(const uint8_t* buf, size_t size, char* hex, size_t hex_size);
+
 /**
  * @brief Converts a hexadecimal string to a long integer.
  *
@@ -105,13 +385,13 @@ long hex2bin(String hex);
  * @brief Converts a hexadecimal encoded string to a byte array.
  *
  * This function takes a hexadecimal encoded string and converts it into a
- * byte array. The function assumes that the provided buffer is large enough
- * to hold the resulting bytes. If the input string's length is odd, the
- * function does nothing.
+ * byte array. If the input string's length is odd, or the decoded bytes do not
+ * fit into `size` bytes, the function does nothing.
  *
  * @note
  * - The input string should be a valid hexadecimal representation with an even length.
- * - Ensure that the provided buffer is allocated with sufficient size to hold the output.
+ * - Use `hex2bytes(const char*, size_t, uint8_t*, size_t)` to learn how many bytes
+ *   were decoded and whether the input was valid.
  *
  * @param hexEncoded The hexadecimal encoded string to be converted.
  * @param buf Pointer to the byte array where the result will be stored.
@@ -119,6 +399,47 @@ long hex2bin(String hex);
  */
 void hex2bytes(String hexEncoded, uint8_t* buf, size_t size);
 
+/**
+ * @brief Decodes hexadecimal characters into a caller-provided byte buffer.
+ *
+ * Upper and lower case digits are accepted and each character is translated with a
+ * single table lookup. The input does not need to be null-terminated, so the function
+ * can decode a field in the middle of a received line.
+ *
+ * @note On failure the content of `buf` is unspecified.
+ *
+ * @param hex Pointer to the hexadecimal characters.
+ * @param len The number of hexadecimal characters, must be even.
+ * @param buf Pointer to the byte array where the result will be stored.
+ * @param size The size of the provided buffer.
+ * @return The number of bytes decoded (`len / 2`), or -1 if `len` is odd, the input
+ *         contains a character that is not a hexadecimal digit, or `buf` is too small.
+ */
+int hex2bytes(const char* hex, size_t len, uint8_t* buf, size_t size);
+
+/**
+ * @brief Checks that `len` characters form a valid input for `hex2bytes()`.
+ *
+ * @param hex Pointer to the characters, which do not need to be null-terminated.
+ * @param len The number of characters.
+ * @return `true` if `len` is even and every character is a hexadecimal digit.
+ */
+bool isHex(const char* hex, size_t len);
+
+/**
+ * @brief Parses a signed decimal integer that must end before `end`.
+ *
+ * Unlike `strtol()`, the scan never reads past `end`, so fields can be parsed from a
+ * buffer that is not null-terminated.
+ *
+ * @param p First character of the number, an optional sign followed by digits.
+ * @param end End of the buffer.
+ * @param value Receives the number.
+ * @return Pointer to the first character after the number, or `nullptr` if there are no
+ *         digits or more than 9 of them.
+ */
+const char* parseInt(const char* p, const char* end, long* value);
+
 /**
  * @brief Validates if the provided string matches a specified length and contains only hexadecimal characters.
  *
@@ -137,26 +458,380 @@ void hex2bytes(String hexEncoded, uint8_t* buf, size_t size);
  */
 bool checkString(const String& key, size_t len);
 
+/**
+ * @brief Validates a C string the same way as `checkString(const String&, size_t)`.
+ *
+ * @param key The null-terminated string to be validated.
+ * @param len The expected length of the string.
+ * @return true if the string matches the expected length and contains only hexadecimal characters;
+ *         false otherwise.
+ */
+bool checkString(const char* key, size_t len);
+
+/**
+ * @brief Copies a null-terminated string into a fixed-size field.
+ *
+ * @param dst The destination field.
+ * @param size The size of `dst`.
+ * @param src The string to copy.
+ * @return `true` if `src` fits; otherwise `dst` is left empty and `false` is returned.
+ */
+bool copyString(char* dst, size_t size, const char* src);
+
+/**
+ * @brief Converts a `rak3172_bps_t` value to a baud rate in bps.
+ *
+ * @param baudRate The baud rate option.
+ * @return The baud rate in bps, 115200 for unknown values.
+ */
+uint32_t bps2baud(rak3172_bps_t baudRate);
+
+/**
+ * @brief Decodes an unsolicited `+EVT:` line into a typed event.
+ *
+ * The event name is looked up in a sorted table, so the cost is linear in the line
+ * length whatever the number of known events.
+ *
+ * @param line The event line without its line terminator.
+ * @param len The length of the line.
+ * @param event Receives the event; its strings point into `line`.
+ * @return `false` if `line` is not an event line, `true` otherwise (possibly with type
+ *         `RAK3172_EVENT_UNKNOWN`).
+ */
+bool parseEvent(const char* line, size_t len, rak3172_event_t* event);
+
 class RAK3172 {
 protected:
-    HardwareSerial* _serial;
+    RAK3172Transport* _transport = nullptr;
+#if defined RAK3172_USE_FREERTOS
+    RAK3172SerialTransport _uart;
+#endif
     int _tx_pin;
     int _rx_pin;
-    SemaphoreHandle_t _serial_mutex;
+    RAK3172Lock _lock;
+    rak3172_result_t _last_result;
+#if defined RAK3172_USE_FREERTOS
+    QueueHandle_t _async_queue = nullptr;
+    TaskHandle_t _async_task   = nullptr;
+    TaskHandle_t _rx_task      = nullptr;
+#else
+    pthread_t _rx_thread;
+    bool _rx_started = false;
+#endif
+    volatile bool _rx_running = false;
+
+    /**
+     * @brief Partially received line, kept across readers until its '\n' arrives.
+     */
+    char _line[RAK3172_LINE_SIZE];
+    size_t _line_len;
+    bool _line_overflow;
+
+    /**
+     * @brief Unsolicited `+EVT:` lines waiting to be handed to `handleEvent()`.
+     *
+     * A ring of records made of a little-endian `uint16_t` length and the line without
+     * its terminator; a record may wrap around the end of the buffer.
+     */
+    uint8_t _events[RAK3172_EVENT_BUFFER_SIZE];
+    size_t _event_head;
+    size_t _event_used;
+    uint16_t _event_count;
+
+    /**
+     * @brief Callback receiving every event after `handleEvent()`, see `onEvent()`.
+     */
+    rak3172_event_cb_t _event_cb = nullptr;
+    void* _event_ctx             = nullptr;
+
+#if RAK3172_STATS
+    /**
+     * @brief Statistics, updated with the serial lock held (frame and event counters
+     *        by the task calling `update()`).
+     */
+    rak3172_stats_t _stats = {};
+
+    /**
+     * @brief Accounts one command round trip in `_stats`.
+     *
+     * @note The caller must hold `_lock`.
+     *
+     * @param cmd The command, or command prefix for payload commands.
+     * @param lock_wait_us Time spent waiting for the serial lock.
+     * @param latency_us Time from sending the command to its final result.
+     * @param bytes_tx Bytes written.
+     * @param bytes_rx Bytes read.
+     * @param result The final result of the command.
+     */
+    void recordCommand(const char* cmd, uint32_t lock_wait_us, uint32_t latency_us, size_t bytes_tx, size_t bytes_rx,
+                       rak3172_result_t result);
+#endif
+
+#if RAK3172_CACHE_SIZE > 0
+    /**
+     * @brief Shadow copies of module parameters, accessed with the serial lock held.
+     */
+    rak3172_cache_entry_t _cache[RAK3172_CACHE_SIZE] = {};
+    uint8_t _cache_next                              = 0;
+    bool _cache_enabled                              = false;
+    bool _diff_apply                                 = false;
+
+    /**
+     * @brief Returns the cache entry of a parameter, or nullptr if it is not cached.
+     *
+     * @note The caller must hold `_lock`.
+     *
+     * @param verb The parameter name without `AT+`, e.g. `DR`.
+     */
+    rak3172_cache_entry_t* findCache(const char* verb);
+
+    /**
+     * @brief Stores the value of a parameter, replacing the oldest entry when the cache is full.
+     *
+     * @note The caller must hold `_lock`.
+     *
+     * @param verb The parameter name without `AT+`.
+     * @param value The value, not necessarily null-terminated.
+     * @param len The length of the value.
+     */
+    void storeCache(const char* verb, const char* value, size_t len);
+
+    /**
+     * @brief Drops the cached values.
+     *
+     * @note The caller must hold `_lock`.
+     *
+     * @param all `true` to also drop the values that never change (version, hardware ID, ...).
+     */
+    void clearCache(bool all);
+
+    /**
+     * @brief Drops the cached parameters the LoRaWAN network can change, see `enableCache()`.
+     */
+    void invalidateNetworkCache();
+
+    /**
+     * @brief Updates the cache after a command completed.
+     *
+     * A successful `AT+<KEY>=<value>` stores the value, `ATZ`/`ATR` and commands that
+     * change other parameters (e.g. `AT+NWM`, `AT+BAND`, `AT+P2P`) drop the cached values.
+     *
+     * @note The caller must hold `_lock`.
+     *
+     * @param cmd The command that was sent.
+     * @param result Its final result.
+     */
+    void updateCache(const char* cmd, rak3172_result_t result);
+
+    /**
+     * @brief Checks whether a setter command can be skipped in diff-apply mode.
+     *
+     * Reads the parameter from the module first if its value is not cached yet.
+     *
+     * @note The caller must not hold `_lock`.
+     *
+     * @param cmd The command, e.g. `AT+DR=3`.
+     * @return `true` if the module already holds the value set by `cmd`.
+     */
+    bool isApplied(const char* cmd);
+
+    /**
+     * @brief Looks the answer to a query up in the shadow cache.
+     *
+     * @note The caller must hold `_lock`.
+     *
+     * @param cmd The command.
+     * @param verb Receives the verb if `cmd` is a query whose answer can be cached, an
+     *        empty string otherwise.
+     * @param verb_size The size of `verb`.
+     * @return The cache entry answering `cmd`, or nullptr.
+     */
+    rak3172_cache_entry_t* cachedQuery(const char* cmd, char* verb, size_t verb_size);
+#endif
+
+    /**
+     * @brief Feeds one received byte into the line demultiplexer.
+     *
+     * This is the only place where bytes read from the module are interpreted, so command
+     * responses and unsolicited events can never be mixed up. Every completed line is
+     * classified as:
+     * - an unsolicited event (`+EVT:...`), which is queued for `handleEvent()`;
+     * - a final result line (`OK`, `AT_ERROR`, ...), which completes the waiting command;
+     * - any other line, which is part of the response of the waiting command.
+     *
+     * @note The caller must hold `_lock`.
+     *
+     * Response lines are parsed in place in `_line`; only the value (if requested) and the
+     * final result are kept, so no response string is built.
+     *
+     * @param c The received byte.
+     * @param result Receives the final result when the function returns `true`, or `nullptr`
+     *        when no command is waiting (response lines are then discarded).
+     * @param value Optional buffer receiving the value of the first response line containing
+     *        '=' (up to the next space), see `getCommand(const char*, char*, size_t, uint32_t)`.
+     *        It must hold an empty string until a value was found.
+     * @param value_size The size of `value`; longer values are truncated.
+     * @return `true` if `c` completed a final result line for a waiting command.
+     */
+    bool feed(char c, rak3172_result_t* result, char* value = nullptr, size_t value_size = 0);
+
+    /**
+     * @brief Appends an event line to `_events`, dropping the oldest lines until it fits.
+     *
+     * Called with the serial mutex held.
+     */
+    void queueEvent(const char* line, size_t len);
+
+    /**
+     * @brief Removes the oldest event line from `_events` and copies it, null-terminated, to `line`.
+     *
+     * Called with the serial mutex held and at least one queued event.
+     *
+     * @param line Receives the line; must hold `RAK3172_LINE_SIZE` bytes.
+     * @return The length of the line.
+     */
+    size_t takeEvent(char* line);
+
+    /**
+     * @brief Reads the module response until a final result line arrives or the timeout expires.
+     *
+     * Incoming bytes go through `feed()`, so the function returns as soon as a final result
+     * line is received instead of waiting for the serial stream to go idle, and event lines
+     * arriving in the middle of the response are queued instead of being swallowed. Only the
+     * value of the response is kept, so no `String` is built.
+     *
+     * @note The caller must hold `_lock`.
+     *
+     * @param value Receives the value, an empty string if the response has none; may be
+     *        `nullptr` when only the result is needed.
+     * @param size The size of `value`.
+     * @param timeout_ms Hard timeout in milliseconds for the whole response.
+     * @param bytes_rx Receives the number of bytes read.
+     * @return The final result of the command, or `RAK3172_RESULT_TIMEOUT`.
+     */
+    rak3172_result_t readResponse(char* value, size_t size, uint32_t timeout_ms, size_t* bytes_rx);
+
+    /**
+     * @brief Sends a query and parses its value as an unsigned decimal number.
+     *
+     * @param cmd The query, e.g. `AT+DR=?`.
+     * @param number Receives the number.
+     * @return `true` if the module answered `OK` with a number.
+     */
+    bool getNumber(const char* cmd, uint32_t* number);
+
+    /**
+     * @brief Sends a query and decodes its hexadecimal value.
+     *
+     * @param cmd The query, e.g. `AT+DEVEUI=?`.
+     * @param buf Receives the decoded bytes.
+     * @param size The expected number of bytes; the value must have exactly `2 * size` digits.
+     * @return `true` if the module answered `OK` with a value of the expected length.
+     */
+    bool getBytes(const char* cmd, uint8_t* buf, size_t size);
+
+    /**
+     * @brief Drains the bytes already received from the module and dispatches queued events.
+     *
+     * The function never waits for data: it takes the serial mutex, feeds the bytes that are
+     * currently available to `feed()`, releases the mutex and then decodes every queued
+     * event line, including those received during earlier commands, with `parseEvent()` and
+     * passes it to `handleEvent()` and to the `onEvent()` callback.
+     */
+    void processInput();
+
+    /**
+     * @brief Handles one unsolicited event received from the module.
+     *
+     * Called by `processInput()` without the serial mutex held, so implementations may send
+     * commands. The default implementation ignores the event.
+     *
+     * @param event The decoded event line, e.g. `+EVT:JOINED`.
+     */
+    virtual void handleEvent(const rak3172_event_t& event);
+
+    /**
+     * @brief Runs time-driven work, such as retry timers.
+     *
+     * Called at the end of every `processInput()` and by the receive task at least every
+     * second while no data arrives, without the serial mutex held. The default
+     * implementation does nothing.
+     */
+    virtual void handleTimers();
+
+    /**
+     * @brief Sends a command and waits for its final result line.
+     *
+     * Shared by `sendCommand()`, the payload commands and the asynchronous worker task.
+     * When `payload` is given, it is hex-encoded in small chunks and streamed to the
+     * serial interface right after `cmd`, so the full hexadecimal command never exists
+     * in memory and the RAM used per command does not depend on the payload size.
+     *
+     * @param cmd The command string (or command prefix, e.g. `AT+SEND=1:`) to be sent.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @param payload Optional binary payload appended to `cmd` as hexadecimal characters.
+     * @param size The size of the payload in bytes.
+     * @return The final result of the command, or `RAK3172_RESULT_TIMEOUT`.
+     */
+    rak3172_result_t runCommand(const char* cmd, uint32_t timeout_ms, const uint8_t* payload = nullptr,
+                                size_t size = 0);
+
+#if defined RAK3172_USE_FREERTOS
+    /**
+     * @brief Queues a command for the asynchronous worker task.
+     *
+     * @param cmd The command string, at most `RAK3172_ASYNC_COMMAND_SIZE - 1` characters.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @param callback Completion callback, may be `nullptr`.
+     * @param ctx User context pointer passed to `callback`.
+     * @param future Completion state to update, may be `nullptr`.
+     * @return `true` if the command was queued, `false` if the worker is not started,
+     *         the command is too long or the queue is full.
+     */
+    bool queueCommand(const char* cmd, uint32_t timeout_ms, rak3172_command_cb_t callback, void* ctx,
+                      rak3172_future_t* future);
+
+    /**
+     * @brief Completes a future without running its command, e.g. if it could not be queued.
+     *
+     * @param future Completion state to complete.
+     * @param result Result to report.
+     */
+    static void failFuture(rak3172_future_t* future, rak3172_result_t result);
+
+    /**
+     * @brief Body of the asynchronous worker task.
+     *
+     * @param arg Pointer to the owning `RAK3172` instance.
+     */
+    static void asyncTask(void* arg);
+#endif
+
+    /**
+     * @brief Body of the receive task, see `beginReceive()`.
+     */
+    void receiveLoop();
+
+#if defined RAK3172_USE_FREERTOS
+    static void receiveTask(void* arg);
+#else
+    static void* receiveTask(void* arg);
+#endif
 
 public:
+#if defined RAK3172_USE_FREERTOS
     /**
      * @brief Initializes the RAK3172 module with the specified serial communication parameters.
      *
      * This function sets up the serial communication (RX, TX pins and baud rate)
-     * for the RAK3172 module and establishes a mutex for synchronizing serial
-     * communication. The function also sends an "AT" command to verify communication
-     * with the module.
+     * for the RAK3172 module and uses it through an internal `RAK3172SerialTransport`.
+     * The function also sends an "AT" command to verify communication with the module.
      *
      * @note
      * - The function assumes that the serial interface is properly connected and
      *   that the RX and TX pins are correctly specified.
-     * - The mutex is created and immediately released after initialization.
+     * - Only available on ESP32 (`RAK3172_USE_FREERTOS`); use `init(RAK3172Transport*)`
+     *   on other platforms.
      * - The function sends an "AT" command to test the connectivity with the RAK3172 module.
      *
      * @param serial A pointer to the `HardwareSerial` object to be used for communication.
@@ -168,14 +843,27 @@ public:
      *         `false` otherwise.
      */
     bool init(HardwareSerial* serial = &Serial2, int rx = 16, int tx = 17, rak3172_bps_t baudRate = RAK3172_BPS_115200);
+#endif
+
+    /**
+     * @brief Initializes the driver on an already opened transport.
+     *
+     * Use this overload to talk to the module over something other than an ESP32
+     * `HardwareSerial`, e.g. a `RAK3172PosixTransport` on a Linux host. The transport
+     * must stay valid as long as the driver is used.
+     *
+     * @param transport The transport connected to the module.
+     * @return `true` if the module answered the "AT" command, `false` otherwise.
+     */
+    bool init(RAK3172Transport* transport);
 
     /**
      * @brief Sends a command to the RAK3172 module and waits for a response.
      *
      * This function sends a specified command string to the RAK3172 module over
      * the serial interface and reads the response. It uses a mutex to ensure
-     * thread-safe access to the serial communication. The function checks if the
-     * response contains "OK" to determine if the command was successful.
+     * thread-safe access to the serial communication. The function returns as soon as
+     * the module answers with a final result line and checks whether it is "OK".
      *
      * @note
      * - The function assumes that the serial interface has been properly initialized
@@ -184,10 +872,286 @@ public:
      *   the response.
      *
      * @param cmd The command string to be sent to the RAK3172 module.
-     * @return `true` if the command was sent successfully and the response contains
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @return `true` if the command was sent successfully and the module answered
      *         "OK", `false` otherwise.
      */
-    bool sendCommand(String cmd);
+    bool sendCommand(const char* cmd, uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT);
+
+    /**
+     * @brief Sends a command held in a `String`, see `sendCommand(const char*, uint32_t)`.
+     *
+     * @param cmd The command string to be sent to the RAK3172 module.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @return `true` if the module answered "OK", `false` otherwise.
+     */
+    bool sendCommand(const String& cmd, uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT);
+
+    /**
+     * @brief Formats a command into a fixed stack buffer and sends it.
+     *
+     * The command is built with `printf`-style formatting into a buffer of
+     * `RAK3172_COMMAND_SIZE` bytes, so no heap memory is used, and the compiler checks
+     * the arguments against the format string.
+     *
+     * @param fmt `printf`-style format of the command, e.g. `"AT+DR=%u"`.
+     * @return `true` if the module answered "OK", `false` otherwise or if the formatted
+     *         command does not fit into the buffer.
+     */
+    bool sendCommandf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+#if RAK3172_STATS
+    /**
+     * @brief Copies the current statistics.
+     *
+     * The counters cover every command sent through `sendCommand()`, `getCommand()`,
+     * the payload commands and the asynchronous worker, plus the events and frames
+     * processed by `update()`. They are cheap enough to stay enabled in production;
+     * define `RAK3172_STATS` to 0 to remove them.
+     *
+     * @param stats Receives the snapshot.
+     */
+    void getStats(rak3172_stats_t* stats);
+
+    /**
+     * @brief Clears all statistics.
+     */
+    void resetStats();
+#endif
+
+    /**
+     * @brief Registers a callback receiving every unsolicited event.
+     *
+     * The callback is called from `update()`, after the event has been handled by the
+     * driver (e.g. a received frame has been queued), for all events including those of
+     * type `RAK3172_EVENT_UNKNOWN`. Applications can use it to react to events without
+     * polling.
+     *
+     * @param callback The callback, or `nullptr` to remove it.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onEvent(rak3172_event_cb_t callback, void* ctx = nullptr);
+
+#if RAK3172_CACHE_SIZE > 0
+    /**
+     * @brief Enables or disables the shadow cache of module parameters (disabled by default).
+     *
+     * With the cache enabled, `getCommand()` and all getters built on it answer queries
+     * (`AT+<KEY>=?`) from a local copy without a UART round trip once the value is known.
+     * Values are filled on the first successful read and on every successful
+     * `AT+<KEY>=<value>` command, so a value that was just set is never read back.
+     * - Values that never change (`VER`, `BUILDTIME`, `HWID`, `SN`, `HWMODEL`, `CLIVER`,
+     *   `APIVER`, `REPOINFO`) stay cached until the next `init()`.
+     * - All other values are dropped on `ATZ`/`ATR` (including `RAK3172P2P::restart()`),
+     *   `setBaudRate()`, a change of work mode, band or P2P configuration, and after a
+     *   LoRaWAN join, which assigns new session parameters.
+     * - Measurements and status values (`BAT`, `SYSV`, `NJS`, `DUTYTIME`, `RSSI`, ...)
+     *   are never cached.
+     *
+     * - Parameters the network can change through ADR and MAC commands (`DR`, `TXP`,
+     *   `MASK`, `RX1DL`, `RX2DL`, `RX2DR`, `RX2FQ`) are dropped by `RAK3172LoRaWAN` after
+     *   every uplink and downlink, so neither a getter nor diff-apply uses a stale value.
+     *
+     * @param enable `true` to enable the cache, `false` to disable it, drop its content and
+     *        leave diff-apply mode.
+     */
+    void enableCache(bool enable);
+
+    /**
+     * @brief Drops all cached values except those that never change.
+     */
+    void invalidateCache();
+
+    /**
+     * @brief Drops the cached value of one parameter.
+     *
+     * @param verb The parameter name without `AT+`, e.g. `"DR"`.
+     */
+    void invalidateCache(const char* verb);
+
+    /**
+     * @brief Reads every cached value that can change again from the module.
+     *
+     * @return `true` if the module answered all queries with `OK`.
+     */
+    bool refreshCache();
+
+    /**
+     * @brief Skips setter commands that would not change anything (disabled by default).
+     *
+     * In diff-apply mode every `AT+<KEY>=<value>` sent through `sendCommand()` and the
+     * setters built on it (`setBAND()`, `setOTAA()`, `setDR()`, `RAK3172P2P::config()`, ...)
+     * is first compared with the shadow cache, reading the parameter from the module once
+     * if it is not cached yet. When the module already holds the value (compared without
+     * regard to case) the command is not sent and the setter reports success, so a boot
+     * path that applies its whole configuration on every wake only sends what changed and
+     * no longer triggers needless NVM writes or mode-change restarts.
+     *
+     * Diff-apply uses the shadow cache and enables it, see `enableCache()`. Actions such as
+     * `AT+JOIN`, `AT+SEND` or `AT+PRECV` are always sent.
+     *
+     * @note The cache lives in RAM; use `saveCache()` and `restoreCache()` to keep the known
+     *       module state across deep sleep instead of reading it again after every wake.
+     *
+     * @param enable `true` to enable diff-apply mode.
+     */
+    void enableDiffApply(bool enable);
+
+    /**
+     * @brief Copies the cached values, e.g. into RTC memory before deep sleep.
+     *
+     * @param entries Destination array.
+     * @param count The number of entries of the destination array.
+     * @return The number of entries written.
+     */
+    size_t saveCache(rak3172_cache_entry_t* entries, size_t count);
+
+    /**
+     * @brief Loads values saved with `saveCache()` into the cache.
+     *
+     * Call it after `init()`, which empties the cache. Invalid entries are ignored.
+     *
+     * @param entries The saved entries.
+     * @param count The number of saved entries.
+     */
+    void restoreCache(const rak3172_cache_entry_t* entries, size_t count);
+#endif
+
+    /**
+     * @brief Returns the final result of the last command sent to the module.
+     *
+     * @return The `rak3172_result_t` of the last `sendCommand()` or `getCommand()` call.
+     */
+    rak3172_result_t getLastResult();
+
+#if defined RAK3172_USE_FREERTOS
+    /**
+     * @brief Starts the worker task that executes asynchronously queued commands.
+     *
+     * Commands queued with `sendCommandAsync()` (and the `*Async()` helpers of the
+     * subclasses) are sent one after the other by this task, so the calling task does
+     * not block while the module processes them.
+     *
+     * @note Call this function after `init()`. Calling it again once the worker is
+     *       running has no effect.
+     *
+     * @param stack_size Stack size of the worker task in bytes.
+     * @param priority FreeRTOS priority of the worker task.
+     * @param core Core the worker task is pinned to, or `tskNO_AFFINITY`.
+     * @return `true` if the worker task is running, `false` if it could not be created.
+     */
+    bool beginAsync(uint32_t stack_size = 4096, UBaseType_t priority = 2, BaseType_t core = tskNO_AFFINITY);
+
+    /**
+     * @brief Queues a command and returns without waiting for the module.
+     *
+     * The worker task started by `beginAsync()` sends the command and calls `callback`
+     * with its final result.
+     *
+     * @param cmd The command string to be sent to the RAK3172 module.
+     * @param callback Completion callback, or `nullptr` to fire and forget.
+     * @param ctx User context pointer passed to `callback`.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @return `true` if the command was queued, `false` otherwise.
+     */
+    bool sendCommandAsync(const char* cmd, rak3172_command_cb_t callback = nullptr, void* ctx = nullptr,
+                          uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT);
+
+    /**
+     * @brief Queues a command held in a `String`, see `sendCommandAsync(const char*, ...)`.
+     *
+     * @param cmd The command string to be sent to the RAK3172 module.
+     * @param callback Completion callback, or `nullptr` to fire and forget.
+     * @param ctx User context pointer passed to `callback`.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @return `true` if the command was queued, `false` otherwise.
+     */
+    bool sendCommandAsync(const String& cmd, rak3172_command_cb_t callback = nullptr, void* ctx = nullptr,
+                          uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT);
+
+    /**
+     * @brief Queues a command and reports its completion through a future.
+     *
+     * @param cmd The command string to be sent to the RAK3172 module.
+     * @param future Caller-owned completion state, reset by this call. It must stay
+     *        valid until the command completed.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @return `true` if the command was queued, `false` otherwise (the future is then
+     *         completed with `RAK3172_RESULT_ERROR`).
+     */
+    bool sendCommandAsync(const char* cmd, rak3172_future_t* future, uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT);
+
+    /**
+     * @brief Queues a command held in a `String`, see `sendCommandAsync(const char*, rak3172_future_t*, uint32_t)`.
+     *
+     * @param cmd The command string to be sent to the RAK3172 module.
+     * @param future Caller-owned completion state, reset by this call.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @return `true` if the command was queued, `false` otherwise.
+     */
+    bool sendCommandAsync(const String& cmd, rak3172_future_t* future, uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT);
+
+    /**
+     * @brief Waits until an asynchronous command completed.
+     *
+     * Blocks on the semaphore of the future, which the worker task gives once the command
+     * completed, instead of polling `done`. Use a timeout of 0 to poll.
+     *
+     * @param future The future passed to `sendCommandAsync()`.
+     * @param timeout_ms Maximum time to wait in milliseconds, `UINT32_MAX` to wait forever.
+     * @return `true` if the command completed, `false` if the wait timed out.
+     */
+    bool wait(rak3172_future_t* future, uint32_t timeout_ms = UINT32_MAX);
+
+    /**
+     * @brief Returns the number of commands still waiting in the asynchronous queue.
+     *
+     * @return The number of queued commands, not counting the one being executed.
+     */
+    size_t pendingCommands();
+
+    /**
+     * @brief Starts a task that calls `update()` whenever the module sends data.
+     *
+     * The task sleeps in `RAK3172Transport::waitAvailable()`, which the serial transport
+     * wakes from the UART receive interrupt, so received frames and events are handled
+     * as soon as their line is complete without polling `update()` from the application.
+     * All callbacks (`onEvent()`, `RAK3172LoRaWAN::onReceive()`, ...) then run in this task.
+     * While the line is idle the task still wakes every second to run `handleTimers()`.
+     *
+     * @note Call this function after `init()`. Calling it again once the task is running
+     *       has no effect.
+     *
+     * @param stack_size Stack size of the receive task in bytes, including the callbacks.
+     * @param priority FreeRTOS priority of the receive task.
+     * @param core Core the receive task is pinned to, or `tskNO_AFFINITY`.
+     * @return `true` if the receive task is running, `false` if it could not be created.
+     */
+    bool beginReceive(uint32_t stack_size = 4096, UBaseType_t priority = 3, BaseType_t core = tskNO_AFFINITY);
+#else
+    /**
+     * @brief Starts a thread that calls `update()` whenever the module sends data.
+     *
+     * The thread sleeps in `poll()` on the transport (see
+     * `RAK3172Transport::waitAvailable()`) and runs all callbacks. While the line is idle
+     * it still wakes every second to run `handleTimers()`.
+     *
+     * @note Call this function after `init()`. Calling it again once the thread is running
+     *       has no effect.
+     *
+     * @param stack_size Stack size of the thread in bytes, 0 for the system default.
+     * @return `true` if the receive thread is running, `false` if it could not be created.
+     */
+    bool beginReceive(size_t stack_size = 0);
+#endif
+
+    /**
+     * @brief Stops the task started by `beginReceive()` and waits until it has exited.
+     *
+     * @note Must not be called from a callback running in the receive task.
+     */
+    void endReceive();
 
     /**
      * @brief Sets the baud rate for communication with the RAK3172 module.
@@ -274,7 +1238,16 @@ public:
      * @return true if the command was successfully sent and acknowledged;
      *         false otherwise.
      */
-    bool setDeviceAlias(String alias);
+    bool setDeviceAlias(const char* alias);
+
+    /**
+     * @brief Sets an alias for the device, see `setDeviceAlias(const char*)`.
+     *
+     * @param alias A string representing the desired alias for the device.
+     * @return true if the command was successfully sent and acknowledged;
+     *         false otherwise.
+     */
+    bool setDeviceAlias(const String& alias);
 
     /**
      * @brief Sends a command to the RAK3172 module and retrieves the response.
@@ -286,11 +1259,65 @@ public:
      *       Debug information can be printed if the RAK3172_DEBUG flag is defined.
      *
      * @param cmd The command string to be sent to the RAK3172 module.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
      *
      * @return A string containing the data extracted from the response.
      *         If the response does not contain valid data, an empty string is returned.
      */
-    String getCommand(String cmd);
+    String getCommand(const char* cmd, uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT);
+
+    /**
+     * @brief Sends a query held in a `String`, see `getCommand(const char*, uint32_t)`.
+     *
+     * @param cmd The command string to be sent to the RAK3172 module.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @return A string containing the data extracted from the response.
+     */
+    String getCommand(const String& cmd, uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT);
+
+    /**
+     * @brief Sends a query and copies its value into a caller buffer.
+     *
+     * The value is the same as returned by `getCommand(const char*, uint32_t)`, but it is
+     * copied straight from the received line, so no `String` is allocated. The typed
+     * getters (e.g. `RAK3172LoRaWAN::getDR(uint8_t&)`) are built on this function.
+     *
+     * @param cmd The query, e.g. `AT+DR=?`.
+     * @param value Receives the null-terminated value.
+     * @param size The size of `value`; longer values are truncated.
+     * @param timeout_ms Hard timeout in milliseconds for the final result line.
+     * @param result Receives the result of this call, also when the value is empty; may be
+     *               `nullptr`. Unlike `getLastResult()` it cannot be overwritten by another task.
+     * @return `true` if the module answered `OK` with a non-empty value.
+     */
+    bool getCommand(const char* cmd, char* value, size_t size, uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT,
+                    rak3172_result_t* result = nullptr);
+
+    /**
+     * @brief Sends several queries in a pipeline and collects their values.
+     *
+     * Up to `RAK3172_PIPELINE_DEPTH` queries are written back to back before the first
+     * response is read, and the next query is written as soon as a response completes, so
+     * the module never waits for the host between two commands. Each response ends at its
+     * final result line, exactly like `getCommand()`. When the shadow cache is enabled,
+     * cached values are used without sending their query.
+     *
+     * @note The serial lock is held for the whole batch; unsolicited events received in the
+     *       meantime are queued for the next `update()`.
+     *
+     * @param cmds The queries, e.g. `"AT+DR=?"`.
+     * @param count The number of queries.
+     * @param values Receives `count` null-terminated values of `value_size` bytes each, in
+     *        the order of `cmds`; the value of a failed query is an empty string.
+     * @param value_size The size of one value; longer values are truncated. Must not be 0.
+     * @param timeout_ms Hard timeout in milliseconds for each response. After a timeout the
+     *        remaining responses can no longer be matched, so the batch stops.
+     * @param result Optional; receives the result of the last response of this batch. Unlike
+     *        `getLastResult()`, it cannot be overwritten by a command from another task.
+     * @return The number of queries answered with `OK`.
+     */
+    size_t getCommands(const char* const* cmds, size_t count, char* values, size_t value_size,
+                       uint32_t timeout_ms = RAK3172_COMMAND_TIMEOUT, rak3172_result_t* result = nullptr);
 
     /**
      * @brief Retrieves the firmware version of the RAK3172 module.
@@ -332,6 +1359,14 @@ public:
      */
     String getBaudRate();
 
+    /**
+     * @brief Reads the baud rate without allocating, see `getBaudRate()`.
+     *
+     * @param baud Receives the baud rate in bps.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getBaudRate(uint32_t& baud);
+
     /**
      * @brief Retrieves the battery voltage of the RAK3172 module.
      *
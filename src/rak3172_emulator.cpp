@@ -0,0 +1,311 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#include "rak3172_emulator.hpp"
+
+static bool isAfter(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) > 0;
+}
+
+RAK3172Emulator::RAK3172Emulator()
+    : _output_count(0),
+      _line_len(0),
+      _latency_us(0),
+      _byte_us(0),
+      _line_free_us(0),
+      _join_delay_ms(100),
+      _tx_delay_ms(50),
+      _join_success(true),
+      _joined(false),
+      _join_pending(false),
+      _join_result(false),
+      _join_ready_us(0),
+      _commands(0)
+{
+    memset(_params, 0, sizeof(_params));
+    setParam("VER", "RUI_4.0.0_RAK3172-E");
+    setParam("NWM", "1");
+    setParam("CFM", "0");
+}
+
+void RAK3172Emulator::setLatency(uint32_t latency_us)
+{
+    _lock.take();
+    _latency_us = latency_us;
+    _lock.give();
+}
+
+void RAK3172Emulator::setJoinResult(uint32_t delay_ms, bool success)
+{
+    _lock.take();
+    _join_delay_ms = delay_ms;
+    _join_success  = success;
+    _lock.give();
+}
+
+void RAK3172Emulator::setTxDelay(uint32_t delay_ms)
+{
+    _lock.take();
+    _tx_delay_ms = delay_ms;
+    _lock.give();
+}
+
+RAK3172Emulator::param_t* RAK3172Emulator::findParam(const char* key, size_t len, bool create)
+{
+    param_t* free_slot = nullptr;
+    if (len >= sizeof(_params[0].key)) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < RAK3172_EMULATOR_PARAMS; i++) {
+        if (_params[i].key[0] == '\0') {
+            if (free_slot == nullptr) {
+                free_slot = &_params[i];
+            }
+        } else if (strncmp(_params[i].key, key, len) == 0 && _params[i].key[len] == '\0') {
+            return &_params[i];
+        }
+    }
+    if (!create || free_slot == nullptr) {
+        return nullptr;
+    }
+    memcpy(free_slot->key, key, len);
+    free_slot->key[len] = '\0';
+    return free_slot;
+}
+
+bool RAK3172Emulator::setParam(const char* key, const char* value)
+{
+    _lock.take();
+    param_t* param = findParam(key, strlen(key), true);
+    bool ok        = param != nullptr && strlen(value) < sizeof(param->value);
+    if (ok) {
+        strcpy(param->value, value);
+    }
+    _lock.give();
+    return ok;
+}
+
+const char* RAK3172Emulator::getParam(const char* key)
+{
+    _lock.take();
+    param_t* param = findParam(key, strlen(key), false);
+    _lock.give();
+    return param != nullptr ? param->value : nullptr;
+}
+
+bool RAK3172Emulator::reply(const char* line, uint32_t delay_us)
+{
+    size_t len = strlen(line);
+    if (_output_count == RAK3172_EMULATOR_OUTPUT || len + 2 > sizeof(_output[0].data)) {
+        return false;
+    }
+    uint32_t now   = micros();
+    uint32_t ready = now + delay_us;
+    if (_output_count == 0) {
+        // The line is idle, so an old end-of-transmission time must not be compared across a timer wrap.
+        _line_free_us = now;
+    }
+    // Keep the queue ordered by time; a line that is being read always stays in front.
+    size_t i = _output_count;
+    while (i > 0 && _output[i - 1].pos == 0 && isAfter(_output[i - 1].ready_us, ready)) {
+        _output[i] = _output[i - 1];
+        i--;
+    }
+    _output[i].ready_us = ready;
+    _output[i].pos      = 0;
+    _output[i].len      = len + 2;
+    memcpy(_output[i].data, line, len);
+    memcpy(_output[i].data + len, "\r\n", 2);
+    _output_count++;
+    return true;
+}
+
+bool RAK3172Emulator::injectEvent(const char* line, uint32_t delay_ms)
+{
+    _lock.take();
+    bool ok = reply(line, delay_ms * 1000);
+    _lock.give();
+    return ok;
+}
+
+uint32_t RAK3172Emulator::commands()
+{
+    return _commands;
+}
+
+void RAK3172Emulator::updateJoin(uint32_t now)
+{
+    // The network state only changes when the join event is emitted.
+    if (_join_pending && !isAfter(_join_ready_us, now)) {
+        _joined       = _join_result;
+        _join_pending = false;
+    }
+}
+
+void RAK3172Emulator::handleLine(char* line)
+{
+    char buf[sizeof(_params[0].key) + sizeof(_params[0].value) + 8];
+    _commands++;
+    updateJoin(micros());
+    if (strcmp(line, "AT") == 0 || strcmp(line, "ATZ") == 0 || strcmp(line, "ATR") == 0) {
+        reply("OK", _latency_us);
+        return;
+    }
+    if (strncmp(line, "AT+", 3) != 0) {
+        reply("AT_COMMAND_NOT_FOUND", _latency_us);
+        return;
+    }
+    char* key = line + 3;
+    char* eq  = strchr(key, '=');
+    if (eq == nullptr) {
+        // "AT+KEY?" help and argument-less commands such as "AT+SLEEP".
+        reply("OK", _latency_us);
+        return;
+    }
+    size_t key_len = eq - key;
+    char* value    = eq + 1;
+    *eq            = '\0';
+    if (strcmp(value, "?") == 0) {
+        param_t* param = findParam(key, key_len, false);
+        if (strcmp(key, "NJS") == 0) {
+            snprintf(buf, sizeof(buf), "AT+NJS=%d", _joined);
+        } else {
+            snprintf(buf, sizeof(buf), "AT+%s=%s", key, param != nullptr ? param->value : "");
+        }
+        reply(buf, _latency_us);
+        reply("OK", _latency_us);
+        return;
+    }
+
+    param_t* nwm = findParam("NWM", 3, false);
+    bool lorawan = nwm != nullptr && strcmp(nwm->value, "1") == 0;
+    if (strcmp(key, "SEND") == 0) {
+        if (!lorawan) {
+            reply("AT_MODE_NO_SUPPORT", _latency_us);
+        } else if (!_joined) {
+            reply("AT_NO_NETWORK_JOINED", _latency_us);
+        } else {
+            param_t* cfm = findParam("CFM", 3, false);
+            reply("OK", _latency_us);
+            reply("+EVT:TX_DONE", _latency_us + _tx_delay_ms * 1000);
+            if (cfm != nullptr && strcmp(cfm->value, "1") == 0) {
+                reply("+EVT:SEND_CONFIRMED_OK", _latency_us + _tx_delay_ms * 2000);
+            }
+        }
+        return;
+    }
+    if (strcmp(key, "PSEND") == 0) {
+        if (lorawan) {
+            reply("AT_MODE_NO_SUPPORT", _latency_us);
+        } else {
+            reply("OK", _latency_us);
+            reply("+EVT:TXP2P DONE", _latency_us + _tx_delay_ms * 1000);
+        }
+        return;
+    }
+    if (strcmp(key, "JOIN") == 0) {
+        if (!lorawan) {
+            reply("AT_MODE_NO_SUPPORT", _latency_us);
+            return;
+        }
+        reply("OK", _latency_us);
+        if (value[0] == '1') {
+            // A new join drops the current session; the result is applied with its event.
+            _joined        = false;
+            _join_pending  = true;
+            _join_result   = _join_success;
+            _join_ready_us = micros() + _latency_us + _join_delay_ms * 1000;
+            reply(_join_success ? "+EVT:JOINED" : "+EVT:JOIN_FAILED", _latency_us + _join_delay_ms * 1000);
+        }
+        return;
+    }
+    if (strcmp(key, "NWM") == 0) {
+        _joined       = false;
+        _join_pending = false;
+    }
+    param_t* param = findParam(key, key_len, true);
+    if (param == nullptr || strlen(value) >= sizeof(param->value)) {
+        reply("AT_PARAM_ERROR", _latency_us);
+        return;
+    }
+    strcpy(param->value, value);
+    reply("OK", _latency_us);
+}
+
+int RAK3172Emulator::peek(uint32_t now)
+{
+    if (_output_count == 0 || isAfter(_output[0].ready_us, now)) {
+        return 0;
+    }
+    if (_byte_us == 0) {
+        return _output[0].len - _output[0].pos;
+    }
+    uint32_t start = isAfter(_line_free_us, _output[0].ready_us) ? _line_free_us : _output[0].ready_us;
+    if (isAfter(start + _byte_us, now)) {
+        return 0;
+    }
+    uint32_t n = (now - start) / _byte_us;
+    return n < (uint32_t)(_output[0].len - _output[0].pos) ? n : _output[0].len - _output[0].pos;
+}
+
+int RAK3172Emulator::available()
+{
+    _lock.take();
+    int n = peek(micros());
+    _lock.give();
+    return n;
+}
+
+int RAK3172Emulator::read()
+{
+    int c = -1;
+    _lock.take();
+    uint32_t now = micros();
+    if (peek(now) > 0) {
+        output_t* out = &_output[0];
+        c             = (uint8_t)out->data[out->pos++];
+        if (_byte_us != 0) {
+            uint32_t start = isAfter(_line_free_us, out->ready_us) ? _line_free_us : out->ready_us;
+            _line_free_us  = start + _byte_us;
+        }
+        if (out->pos == out->len) {
+            _output_count--;
+            memmove(&_output[0], &_output[1], _output_count * sizeof(_output[0]));
+        }
+    }
+    _lock.give();
+    return c;
+}
+
+size_t RAK3172Emulator::write(const uint8_t* buf, size_t size)
+{
+    _lock.take();
+    for (size_t i = 0; i < size; i++) {
+        char c = buf[i];
+        if (c == '\n') {
+            if (_line_len > 0 && _line[_line_len - 1] == '\r') {
+                _line_len--;
+            }
+            _line[_line_len] = '\0';
+            handleLine(_line);
+            _line_len = 0;
+        } else if (_line_len < sizeof(_line) - 1) {
+            _line[_line_len++] = c;
+        }
+    }
+    _lock.give();
+    return size;
+}
+
+bool RAK3172Emulator::setBaudRate(uint32_t baud)
+{
+    _lock.take();
+    // 10 bits per byte on an 8N1 line.
+    _byte_us = baud != 0 ? 10000000 / baud : 0;
+    _lock.give();
+    return true;
+}
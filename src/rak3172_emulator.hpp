@@ -0,0 +1,148 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#ifndef _RAK3172_EMULATOR_HPP_
+#define _RAK3172_EMULATOR_HPP_
+
+#include <Arduino.h>
+#include "rak3172_common.hpp"
+
+/**
+ * @def RAK3172_EMULATOR_PARAMS
+ * @brief Number of `AT+<KEY>` values the emulator can store.
+ */
+#ifndef RAK3172_EMULATOR_PARAMS
+#define RAK3172_EMULATOR_PARAMS 64
+#endif
+
+/**
+ * @def RAK3172_EMULATOR_OUTPUT
+ * @brief Number of response or event lines the emulator can hold before they are read.
+ */
+#ifndef RAK3172_EMULATOR_OUTPUT
+#define RAK3172_EMULATOR_OUTPUT 32
+#endif
+
+/**
+ * @brief Simulated RAK3172 module speaking the subset of the RUI3 AT protocol used by this library.
+ *
+ * The emulator is a `RAK3172Transport`, so it can be passed to `init(RAK3172Transport*)`
+ * of `RAK3172LoRaWAN` or `RAK3172P2P` in place of a real UART. It is meant for tests and
+ * benchmarks without a radio:
+ * - Every `AT+<KEY>=<value>` is stored and returned by `AT+<KEY>=?`.
+ * - `AT+JOIN` answers `OK` and reports `+EVT:JOINED` (or `+EVT:JOIN_FAILED`) after the
+ *   join delay; `AT+NJS=?` reports the joined state from that moment on. `AT+SEND`
+ *   requires LoRaWAN mode and a joined network and reports `+EVT:TX_DONE`; `AT+PSEND`
+ *   requires P2P mode and reports `+EVT:TXP2P DONE`.
+ * - Responses are delayed by a configurable latency and, when a baud rate is set, each
+ *   byte becomes readable only after its transmission time on the UART.
+ * - Additional `+EVT:` lines can be scripted with `injectEvent()`.
+ *
+ * All methods are thread-safe, so events can be injected from a test thread while the
+ * driver is running.
+ */
+class RAK3172Emulator : public RAK3172Transport {
+public:
+    RAK3172Emulator();
+
+    /**
+     * @brief Sets the delay between the end of a command and the first byte of its response.
+     *
+     * @param latency_us The latency in microseconds (default 0).
+     */
+    void setLatency(uint32_t latency_us);
+
+    /**
+     * @brief Sets the delay between `AT+JOIN` and its join event.
+     *
+     * @param delay_ms The delay in milliseconds (default 100).
+     * @param success `true` to report `+EVT:JOINED`, `false` for `+EVT:JOIN_FAILED`.
+     */
+    void setJoinResult(uint32_t delay_ms, bool success = true);
+
+    /**
+     * @brief Sets the delay between `AT+SEND`/`AT+PSEND` and their TX done event.
+     *
+     * @param delay_ms The simulated time on air in milliseconds (default 50).
+     */
+    void setTxDelay(uint32_t delay_ms);
+
+    /**
+     * @brief Presets the value returned by `AT+<KEY>=?`.
+     *
+     * @param key The parameter name without the `AT+` prefix, e.g. `"VER"`.
+     * @param value The value.
+     * @return `true` if the value was stored.
+     */
+    bool setParam(const char* key, const char* value);
+
+    /**
+     * @brief Returns the stored value of a parameter, or nullptr if it was never set.
+     *
+     * @param key The parameter name without the `AT+` prefix.
+     */
+    const char* getParam(const char* key);
+
+    /**
+     * @brief Schedules an unsolicited line, e.g. `"+EVT:RX_1:-40:8:UNICAST:2:cafe"`.
+     *
+     * @param line The line without its terminator.
+     * @param delay_ms Time from now after which the line is sent.
+     * @return `true` if the line was scheduled, `false` if the output queue is full.
+     */
+    bool injectEvent(const char* line, uint32_t delay_ms = 0);
+
+    /**
+     * @brief Returns the number of command lines received so far.
+     */
+    uint32_t commands();
+
+    int available() override;
+    int read() override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    bool setBaudRate(uint32_t baud) override;
+    using RAK3172Transport::read;
+    using RAK3172Transport::write;
+
+private:
+    typedef struct {
+        char key[16];
+        char value[128];
+    } param_t;
+
+    typedef struct {
+        uint32_t ready_us;
+        uint16_t pos;
+        uint16_t len;
+        char data[RAK3172_ASYNC_COMMAND_SIZE];
+    } output_t;
+
+    void handleLine(char* line);
+    void updateJoin(uint32_t now);
+    bool reply(const char* line, uint32_t delay_us);
+    param_t* findParam(const char* key, size_t len, bool create);
+    int peek(uint32_t now);
+
+    RAK3172Lock _lock;
+    param_t _params[RAK3172_EMULATOR_PARAMS];
+    output_t _output[RAK3172_EMULATOR_OUTPUT];
+    uint8_t _output_count;
+    char _line[RAK3172_ASYNC_COMMAND_SIZE];
+    size_t _line_len;
+    uint32_t _latency_us;
+    uint32_t _byte_us;
+    uint32_t _line_free_us;
+    uint32_t _join_delay_ms;
+    uint32_t _tx_delay_ms;
+    bool _join_success;
+    bool _joined;
+    bool _join_pending;
+    bool _join_result;
+    uint32_t _join_ready_us;
+    uint32_t _commands;
+};
+
+#endif
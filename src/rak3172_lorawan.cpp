@@ -6,93 +6,159 @@
 
 #include "rak3172_lorawan.hpp"
 
+#if defined RAK3172_USE_FREERTOS
 bool RAK3172LoRaWAN::init(HardwareSerial* serial, int rx, int tx, rak3172_bps_t baudRate)
 {
-    RAK3172::init(serial, rx, tx, baudRate);
+    _tx_pin = tx;
+    _rx_pin = rx;
+    _uart.begin(serial, bps2baud(baudRate), rx, tx);
+    return init(&_uart);
+}
+#endif
+
+bool RAK3172LoRaWAN::init(RAK3172Transport* transport)
+{
+    RAK3172::init(transport);
     delay(100);
     return (sendCommand("AT+NWM=1") && sendCommand("AT"));
 }
 
-bool RAK3172LoRaWAN::setApplicationIdentifier(const String& identifier)
+bool RAK3172LoRaWAN::setApplicationIdentifier(const char* identifier)
 {
     if (!checkString(identifier, 8)) {
         return false;
     }
-    return sendCommand("AT+APPEUI=" + identifier);
+    return sendCommandf("AT+APPEUI=%s", identifier);
 }
 
-bool RAK3172LoRaWAN::setApplicationKey(const String& key)
+bool RAK3172LoRaWAN::setApplicationIdentifier(const String& identifier)
+{
+    return setApplicationIdentifier(identifier.c_str());
+}
+
+bool RAK3172LoRaWAN::setApplicationKey(const char* key)
 {
     if (!checkString(key, 16)) {
         return false;
     }
-    return sendCommand("AT+APPKEY=" + key);
+    return sendCommandf("AT+APPKEY=%s", key);
 }
 
-bool RAK3172LoRaWAN::setApplicationSessionKey(const String& key)
+bool RAK3172LoRaWAN::setApplicationKey(const String& key)
+{
+    return setApplicationKey(key.c_str());
+}
+
+bool RAK3172LoRaWAN::setApplicationSessionKey(const char* key)
 {
     if (!checkString(key, 16)) {
         return false;
     }
-    return sendCommand("AT+APPSKEY=" + key);
+    return sendCommandf("AT+APPSKEY=%s", key);
 }
 
-bool RAK3172LoRaWAN::setNetworkSessionKey(const String& key)
+bool RAK3172LoRaWAN::setApplicationSessionKey(const String& key)
+{
+    return setApplicationSessionKey(key.c_str());
+}
+
+bool RAK3172LoRaWAN::setNetworkSessionKey(const char* key)
 {
     if (!checkString(key, 16)) {
         return false;
     }
-    return sendCommand("AT+NWKSKEY=" + key);
+    return sendCommandf("AT+NWKSKEY=%s", key);
 }
 
-bool RAK3172LoRaWAN::setDevAddr(const String& addr)
+bool RAK3172LoRaWAN::setNetworkSessionKey(const String& key)
+{
+    return setNetworkSessionKey(key.c_str());
+}
+
+bool RAK3172LoRaWAN::setDevAddr(const char* addr)
 {
     if (!checkString(addr, 4)) {
         return false;
     }
-    return sendCommand("AT+DEVADDR=" + addr);
+    return sendCommandf("AT+DEVADDR=%s", addr);
 }
 
-bool RAK3172LoRaWAN::setDevEUI(const String& eui)
+bool RAK3172LoRaWAN::setDevAddr(const String& addr)
+{
+    return setDevAddr(addr.c_str());
+}
+
+bool RAK3172LoRaWAN::setDevEUI(const char* eui)
 {
     if (!checkString(eui, 8)) {
         return false;
     }
-    return sendCommand("AT+DEVEUI=" + eui);
+    return sendCommandf("AT+DEVEUI=%s", eui);
+}
+
+bool RAK3172LoRaWAN::setDevEUI(const String& eui)
+{
+    return setDevEUI(eui.c_str());
 }
 
-bool RAK3172LoRaWAN::setBAND(String band, String channel_mask)
+bool RAK3172LoRaWAN::setBAND(const char* band, const char* channel_mask)
 {
-    if (band == "1" || band == "5" || band == "6") {
-        return sendCommand("AT+BAND=" + band) && sendCommand("AT+MASK=" + channel_mask);
+    if (strcmp(band, "1") == 0 || strcmp(band, "5") == 0 || strcmp(band, "6") == 0) {
+        return sendCommandf("AT+BAND=%s", band) && sendCommandf("AT+MASK=%s", channel_mask);
     }
-    return sendCommand("AT+BAND=" + band);
+    return sendCommandf("AT+BAND=%s", band);
+}
+
+bool RAK3172LoRaWAN::setBAND(const String& band, const String& channel_mask)
+{
+    return setBAND(band.c_str(), channel_mask.c_str());
 }
 
-bool RAK3172LoRaWAN::setOTAA(String deveui, String appeui, String appkey)
+bool RAK3172LoRaWAN::setOTAA(const char* deveui, const char* appeui, const char* appkey)
 {
     _join_mode = OTAA;
-    return (sendCommand("AT+NJM=1") && sendCommand("AT+DEVEUI=" + deveui) && sendCommand("AT+APPEUI=" + appeui) &&
-            sendCommand("AT+APPKEY=" + appkey));
+    return (sendCommand("AT+NJM=1") && sendCommandf("AT+DEVEUI=%s", deveui) && sendCommandf("AT+APPEUI=%s", appeui) &&
+            sendCommandf("AT+APPKEY=%s", appkey));
 }
 
-bool RAK3172LoRaWAN::setABP(String devaddr, String nwkskey, String appskey)
+bool RAK3172LoRaWAN::setOTAA(const String& deveui, const String& appeui, const String& appkey)
+{
+    return setOTAA(deveui.c_str(), appeui.c_str(), appkey.c_str());
+}
+
+bool RAK3172LoRaWAN::setABP(const char* devaddr, const char* nwkskey, const char* appskey)
 {
     _join_mode = ABP;
-    return (sendCommand("AT+NJM=0") && sendCommand("AT+DEVADDR=" + devaddr) && sendCommand("AT+NWKSKEY=" + nwkskey) &&
-            sendCommand("AT+APPSKEY=" + appskey));
+    return (sendCommand("AT+NJM=0") && sendCommandf("AT+DEVADDR=%s", devaddr) &&
+            sendCommandf("AT+NWKSKEY=%s", nwkskey) && sendCommandf("AT+APPSKEY=%s", appskey));
+}
+
+bool RAK3172LoRaWAN::setABP(const String& devaddr, const String& nwkskey, const String& appskey)
+{
+    return setABP(devaddr.c_str(), nwkskey.c_str(), appskey.c_str());
+}
+
+bool RAK3172LoRaWAN::setADDMulc(const char* mode, const char* devaddr, const char* nwkskey, const char* appskey,
+                                uint32_t freq, uint8_t dataRate, uint8_t periodicity)
+{
+    return sendCommandf("AT+ADDMULC=%s:%s:%s:%s:%lu:%u:%u", mode, devaddr, nwkskey, appskey, (unsigned long)freq,
+                        dataRate, periodicity);
 }
 
-bool RAK3172LoRaWAN::setADDMulc(String mode, String devaddr, String nwkskey, String appskey, uint32_t freq,
-                                uint8_t dataRate, uint8_t periodicity)
+bool RAK3172LoRaWAN::setADDMulc(const String& mode, const String& devaddr, const String& nwkskey,
+                                const String& appskey, uint32_t freq, uint8_t dataRate, uint8_t periodicity)
 {
-    return ("AT+ADDMULC=" + String(mode) + ":" + String(devaddr) + ":" + String(nwkskey) + ":" + String(appskey) + ":" +
-            String(freq) + ":" + String(dataRate) + ":" + String(periodicity));
+    return setADDMulc(mode.c_str(), devaddr.c_str(), nwkskey.c_str(), appskey.c_str(), freq, dataRate, periodicity);
 }
 
-bool RAK3172LoRaWAN::detelRmvmulc(String devaddr)
+bool RAK3172LoRaWAN::detelRmvmulc(const char* devaddr)
 {
-    return ("AT+RMVMULC=" + String(devaddr));
+    return sendCommandf("AT+RMVMULC=%s", devaddr);
+}
+
+bool RAK3172LoRaWAN::detelRmvmulc(const String& devaddr)
+{
+    return detelRmvmulc(devaddr.c_str());
 }
 
 bool RAK3172LoRaWAN::setMode(lorawan_dev_class_t mode)
@@ -152,23 +218,120 @@ bool RAK3172LoRaWAN::setLBT(bool lb)
 
 bool RAK3172LoRaWAN::join(bool enable, bool boot_auto_join, uint8_t retry_interval, uint8_t retry_times)
 {
-    if (_join_mode == OTAA) {
-        return sendCommand("AT+JOIN=" + String(enable) + ":" + String(boot_auto_join) + ":" + String(retry_interval) +
-                           ":" + String(retry_times));
-    } else {
+    if (_join_mode != OTAA ||
+        !sendCommandf("AT+JOIN=%d:%d:%u:%u", enable, boot_auto_join, retry_interval, retry_times)) {
         return false;
     }
+    if (enable) {
+        // A new join drops the current session.
+        _join_lock.take();
+        _is_joined = false;
+        if (_join_state == LORAWAN_JOIN_JOINED) {
+            _join_state = LORAWAN_JOIN_IDLE;
+            dropUplinks();
+        }
+        _join_lock.give();
+    }
+    return true;
+}
+
+bool RAK3172LoRaWAN::beginJoin(uint32_t max_attempts)
+{
+    uint32_t now = millis();
+    if (_join_mode != OTAA) {
+        return false;
+    }
+    _join_lock.take();
+    _join_state        = LORAWAN_JOIN_WAITING;
+    _join_max_attempts = max_attempts;
+    _join_start        = now;
+    // Spread the first requests of devices powered up at the same time.
+    _join_deadline = now + random(RAK3172_JOIN_BACKOFF_MIN_MS);
+    _join_stats    = {};
+    _is_joined     = false;
+    _join_lock.give();
+    return true;
+}
+
+void RAK3172LoRaWAN::cancelJoin()
+{
+    _join_lock.take();
+    if (_join_state == LORAWAN_JOIN_WAITING || _join_state == LORAWAN_JOIN_JOINING) {
+        _join_state = LORAWAN_JOIN_IDLE;
+    }
+    dropUplinks();
+    _join_lock.give();
+}
+
+lorawan_join_state_t RAK3172LoRaWAN::getJoinState()
+{
+    return _join_state;
+}
+
+bool RAK3172LoRaWAN::isJoined()
+{
+    return _is_joined;
+}
+
+void RAK3172LoRaWAN::getJoinStats(lorawan_join_stats_t* stats)
+{
+    uint32_t now = millis();
+    _join_lock.take();
+    *stats                 = _join_stats;
+    stats->uplinks_held    = _uplink_count;
+    stats->next_attempt_ms = 0;
+    if (_join_state == LORAWAN_JOIN_WAITING && (int32_t)(_join_deadline - now) > 0) {
+        stats->next_attempt_ms = _join_deadline - now;
+    }
+    _join_lock.give();
+}
+
+void RAK3172LoRaWAN::joinFailed(uint32_t now)
+{
+    _join_stats.failures++;
+    if (_join_max_attempts > 0 && _join_stats.attempts >= _join_max_attempts) {
+        _join_state = LORAWAN_JOIN_FAILED;
+        dropUplinks();
+    } else {
+        _join_state    = LORAWAN_JOIN_WAITING;
+        _join_deadline = now + joinBackoff(now);
+    }
+}
+
+uint32_t RAK3172LoRaWAN::joinBackoff(uint32_t now)
+{
+    uint32_t elapsed  = now - _join_start;
+    uint32_t delay_ms = RAK3172_JOIN_BACKOFF_MIN_MS;
+    uint32_t min_ms;
+    // Join request duty cycle: 1% during the first hour, 0.1% until the 11th hour, 0.01% afterwards
+    if (elapsed < 3600000UL) {
+        min_ms = RAK3172_JOIN_AIRTIME_MS * 100UL;
+    } else if (elapsed < 11 * 3600000UL) {
+        min_ms = RAK3172_JOIN_AIRTIME_MS * 1000UL;
+    } else {
+        min_ms = RAK3172_JOIN_AIRTIME_MS * 10000UL;
+    }
+    for (uint32_t i = 1; i < _join_stats.failures && delay_ms < RAK3172_JOIN_BACKOFF_MAX_MS; i++) {
+        delay_ms *= 2;
+    }
+    if (delay_ms > RAK3172_JOIN_BACKOFF_MAX_MS) {
+        delay_ms = RAK3172_JOIN_BACKOFF_MAX_MS;
+    }
+    if (delay_ms < min_ms) {
+        delay_ms = min_ms;
+    }
+    return delay_ms + random(delay_ms / 2 + 1);
 }
 
 bool RAK3172LoRaWAN::setRetransmission(uint8_t num)
 {
-    return sendCommand("AT+RETY=" + String(num));
+    return sendCommandf("AT+RETY=%u", num);
 }
 
 bool RAK3172LoRaWAN::setJoinRX1Delay(uint8_t sec)
 {
     if (_join_mode == OTAA) {
-        return sendCommand("AT+JN1DL=" + String(sec));
+        return sendCommandf("AT+JN1DL=%u", sec);
     } else {
         return false;
     }
@@ -177,7 +340,7 @@ bool RAK3172LoRaWAN::setJoinRX1Delay(uint8_t sec)
 bool RAK3172LoRaWAN::setJoinRX2Delay(uint8_t sec)
 {
     if (_join_mode == OTAA) {
-        return sendCommand("AT+JN2DL=" + String(sec));
+        return sendCommandf("AT+JN2DL=%u", sec);
     } else {
         return false;
     }
@@ -185,27 +348,27 @@ bool RAK3172LoRaWAN::setJoinRX2Delay(uint8_t sec)
 
 bool RAK3172LoRaWAN::setRX1Delay(uint8_t sec)
 {
-    return sendCommand("AT+RX1DL=" + String(sec));
+    return sendCommandf("AT+RX1DL=%u", sec);
 }
 
 bool RAK3172LoRaWAN::setRX2Delay(uint8_t sec)
 {
-    return sendCommand("AT+RX2DL=" + String(sec));
+    return sendCommandf("AT+RX2DL=%u", sec);
 }
 
 bool RAK3172LoRaWAN::setRX2DR(uint8_t dr)
 {
-    return sendCommand("AT+RX2DR=" + String(dr));
+    return sendCommandf("AT+RX2DR=%u", dr);
 }
 
 bool RAK3172LoRaWAN::setDR(uint8_t dr)
 {
-    return sendCommand("AT+DR=" + String(dr));
+    return sendCommandf("AT+DR=%u", dr);
 }
 
 bool RAK3172LoRaWAN::setOutPower(uint8_t power)
 {
-    return sendCommand("AT+TXP=" + String(power));
+    return sendCommandf("AT+TXP=%u", power);
 }
 
 bool RAK3172LoRaWAN::setComfirm(bool comfirm)
@@ -217,118 +380,489 @@ bool RAK3172LoRaWAN::setComfirm(bool comfirm)
     }
 }
 
-size_t RAK3172LoRaWAN::send(String data, int port)
+size_t RAK3172LoRaWAN::send(String data, int port, lorawan_send_status_t* status)
 {
-    String hexEncoded = encodeMsg(data);
-    if (sendCommand("AT+SEND=" + String(port) + ":" + hexEncoded)) {
-        return data.length();
-    };
-    return 0;
+    return send((const uint8_t*)data.c_str(), data.length(), port, status);
 }
 
-size_t RAK3172LoRaWAN::send(const uint8_t* buf, size_t size, int port)
+size_t RAK3172LoRaWAN::send(const char* data, int port, lorawan_send_status_t* status)
 {
-    String hexEncoded = bytes2hex(buf, size);
-    if (sendCommand("AT+SEND=" + String(port) + ":" + hexEncoded)) {
-        return size;
-    };
-    return 0;
+    return send((const uint8_t*)data, strlen(data), port, status);
 }
 
-void RAK3172LoRaWAN::parse(String frame)
+size_t RAK3172LoRaWAN::send(const uint8_t* buf, size_t size, int port, lorawan_send_status_t* status)
+{
+    char prefix[16];
+    bool pending;
+    lorawan_send_status_t result = LORAWAN_SEND_ERROR;
+    size_t held                  = holdUplink(buf, size, port, &pending);
+    if (pending) {
+        if (held > 0) {
+            result = LORAWAN_SEND_HELD;
+            if (_is_joined) {
+                flushUplinks();
+            }
+        }
+        size = 0;
+    } else {
+        snprintf(prefix, sizeof(prefix), "AT+SEND=%d:", port);
+        if (runCommand(prefix, RAK3172_COMMAND_TIMEOUT, buf, size) == RAK3172_RESULT_OK) {
+            result = LORAWAN_SEND_OK;
+        } else {
+            size = 0;
+        }
+    }
+    if (status != nullptr) {
+        *status = result;
+    }
+    return size;
+}
+
+void RAK3172LoRaWAN::dropUplinks()
+{
+    _join_stats.uplinks_dropped += _uplink_count;
+    _uplink_head    = 0;
+    _uplink_count   = 0;
+    _uplink_retries = 0;
+}
+
+size_t RAK3172LoRaWAN::holdUplink(const uint8_t* buf, size_t size, int port, bool* pending)
+{
+    lorawan_uplink_t* uplink;
+    _join_lock.take();
+    // Once uplinks are held, later ones queue behind them to keep their order.
+    *pending = _join_state == LORAWAN_JOIN_WAITING || _join_state == LORAWAN_JOIN_JOINING ||
+               (_join_state == LORAWAN_JOIN_JOINED && (_uplink_count > 0 || _flushing));
+    if (!*pending || size > RAK3172_UPLINK_SIZE || port < 0 || port > 255) {
+        _join_lock.give();
+        return 0;
+    }
+    if (_uplink_count == RAK3172_UPLINK_QUEUE_SIZE) {
+        _uplink_head = (_uplink_head + 1) % RAK3172_UPLINK_QUEUE_SIZE;
+        _uplink_count--;
+        _join_stats.uplinks_dropped++;
+    }
+    uplink       = &_uplinks[(_uplink_head + _uplink_count) % RAK3172_UPLINK_QUEUE_SIZE];
+    uplink->port = port;
+    uplink->len  = size;
+    memcpy(uplink->data, buf, size);
+    _uplink_count++;
+    _join_lock.give();
+    return size;
+}
+
+void RAK3172LoRaWAN::flushUplinks()
+{
+    lorawan_uplink_t uplink;
+    char prefix[16];
+    rak3172_result_t result;
+    for (;;) {
+        _join_lock.take();
+        if (_flushing || _join_state != LORAWAN_JOIN_JOINED || _uplink_count == 0 ||
+            (_uplink_retries > 0 && (int32_t)(millis() - _uplink_deadline) < 0)) {
+            _join_lock.give();
+            return;
+        }
+        uplink       = _uplinks[_uplink_head];
+        _uplink_head = (_uplink_head + 1) % RAK3172_UPLINK_QUEUE_SIZE;
+        _uplink_count--;
+        _flushing = true;
+        _join_lock.give();
+
+        snprintf(prefix, sizeof(prefix), "AT+SEND=%u:", uplink.port);
+        result = runCommand(prefix, RAK3172_COMMAND_TIMEOUT, uplink.data, uplink.len);
+
+        _join_lock.take();
+        _flushing = false;
+        if (result == RAK3172_RESULT_BUSY_ERROR && _join_state == LORAWAN_JOIN_JOINED &&
+            _uplink_count < RAK3172_UPLINK_QUEUE_SIZE) {
+            // Still in the receive windows or duty cycle of the previous uplink: retry from handleTimers().
+            uint32_t delay_ms = RAK3172_UPLINK_RETRY_MIN_MS;
+            for (uint8_t i = 0; i < _uplink_retries && delay_ms < RAK3172_UPLINK_RETRY_MAX_MS; i++) {
+                delay_ms *= 2;
+            }
+            if (delay_ms > RAK3172_UPLINK_RETRY_MAX_MS) {
+                delay_ms = RAK3172_UPLINK_RETRY_MAX_MS;
+            }
+            if (_uplink_retries < UINT8_MAX) {
+                _uplink_retries++;
+            }
+            _uplink_deadline       = millis() + delay_ms;
+            _uplink_head           = (_uplink_head + RAK3172_UPLINK_QUEUE_SIZE - 1) % RAK3172_UPLINK_QUEUE_SIZE;
+            _uplinks[_uplink_head] = uplink;
+            _uplink_count++;
+            _join_lock.give();
+            return;
+        }
+        _uplink_retries = 0;
+        if (result != RAK3172_RESULT_OK) {
+            _join_stats.uplinks_dropped++;
+        }
+        _join_lock.give();
+    }
+}
+
+#if defined RAK3172_USE_FREERTOS
+static bool formatSend(char* cmd, size_t cmd_size, const uint8_t* buf, size_t size, int port)
+{
+    int len = snprintf(cmd, cmd_size, "AT+SEND=%d:", port);
+    if (len < 0 || (size_t)len + size * 2 >= cmd_size) {
+        return false;
+    }
+    bytes2hex(buf, size, cmd + len, cmd_size - len);
+    return true;
+}
+
+bool RAK3172LoRaWAN::sendAsync(const uint8_t* buf, size_t size, int port, rak3172_command_cb_t callback, void* ctx)
+{
+    char cmd[RAK3172_ASYNC_COMMAND_SIZE];
+    if (!formatSend(cmd, sizeof(cmd), buf, size, port)) {
+        return false;
+    }
+    return sendCommandAsync(cmd, callback, ctx);
+}
+
+bool RAK3172LoRaWAN::sendAsync(const uint8_t* buf, size_t size, int port, rak3172_future_t* future)
+{
+    char cmd[RAK3172_ASYNC_COMMAND_SIZE];
+    if (!formatSend(cmd, sizeof(cmd), buf, size, port)) {
+        failFuture(future, RAK3172_RESULT_PARAM_OVERFLOW);
+        return false;
+    }
+    return sendCommandAsync(cmd, future);
+}
+#endif
+
+lorawan_frame_t* RAK3172LoRaWAN::parseFrame(const char* line, size_t len)
 {
-    lorawan_frame_t res;
     // +EVT:RX_1:-38:13:UNICAST:1:12312312
-    int index = frame.indexOf("+EVT:RX_");
-    if (index != -1) {
-        String tmp     = frame.substring(index + 10);
-        int rssi       = tmp.substring(0, tmp.indexOf(":")).toInt();
-        tmp            = tmp.substring(tmp.indexOf(":") + 1);
-        int snr        = tmp.substring(0, tmp.indexOf(":")).toInt();
-        tmp            = tmp.substring(tmp.indexOf(":") + 1);
-        bool unicast   = tmp.substring(0, tmp.indexOf(":")) == "UNICAST";
-        tmp            = tmp.substring(tmp.indexOf(":") + 1);
-        int port       = tmp.substring(0, tmp.indexOf(":")).toInt();
-        tmp            = tmp.substring(tmp.indexOf(":") + 1);
-        String payload = decodeMsg(tmp);
-        res.rssi       = rssi;
-        res.snr        = snr;
-        res.unicast    = unicast;
-        res.port       = port;
-        res.len        = payload.length();
-        payload.toCharArray(res.payload, payload.length() + 1);
-        _frames.push_back(res);
+    const char* end = line + len;
+    const char* p;
+    long rssi, snr, port;
+    bool unicast;
+    lorawan_frame_t* res;
+
+    if (len < 8 || memcmp(line, "+EVT:RX_", 8) != 0 || (p = (const char*)memchr(line + 8, ':', len - 8)) == nullptr) {
+        return nullptr;
+    }
+    if ((p = parseInt(p + 1, end, &rssi)) == nullptr || p == end || *p != ':') {
+        return nullptr;
     }
+    if ((p = parseInt(p + 1, end, &snr)) == nullptr || p == end || *p != ':') {
+        return nullptr;
+    }
+    p++;
+    unicast = end - p >= 8 && memcmp(p, "UNICAST:", 8) == 0;
+    if ((p = (const char*)memchr(p, ':', end - p)) == nullptr || (p = parseInt(p + 1, end, &port)) == nullptr) {
+        return nullptr;
+    }
+    if (p < end && *p == ':') {
+        p++;
+    }
+    // Validate the payload before reserving a slot, which may evict the oldest frame.
+    if (!isHex(p, end - p) || (size_t)(end - p) / 2 > sizeof(res->payload) - 1) {
+#if defined RAK3172_DEBUG
+        serialPrintln("INVALID RX PAYLOAD");
+#else
+#endif
+        return nullptr;
+    }
+#if RAK3172_STATS
+    uint32_t dropped = _frames.dropped();
+    res              = _frames.reserve();
+    _stats.frames_dropped += _frames.dropped() - dropped;
+#else
+    res = _frames.reserve();
+#endif
+    if (res == nullptr) {
+        return nullptr;
+    }
+    res->len               = hex2bytes(p, end - p, (uint8_t*)res->payload, sizeof(res->payload) - 1);
+    res->payload[res->len] = '\0';
+    res->rssi              = rssi;
+    res->snr               = snr;
+    res->unicast           = unicast;
+    res->port              = port;
+    _frames.commit();
+#if RAK3172_STATS
+    _stats.frames_parsed++;
+#endif
+    return res;
+}
+
+void RAK3172LoRaWAN::parse(const char* line, size_t len)
+{
+    parseFrame(line, len);
+}
+
+void RAK3172LoRaWAN::parse(String frame)
+{
+    parse(frame.c_str(), frame.length());
 }
 
 void RAK3172LoRaWAN::update()
 {
-    String res = "";
-    if (xSemaphoreTake(_serial_mutex, portMAX_DELAY) == pdTRUE) {
-        String res = _serial->readStringUntil('\n');
-        xSemaphoreGive(_serial_mutex);
-        if (res.indexOf("+EVT:LINKCHECK") != -1) {
-        }
+    processInput();
+}
 
-        if (res.indexOf("+EVT:JOINED") != -1) {
+void RAK3172LoRaWAN::handleEvent(const rak3172_event_t& event)
+{
+    lorawan_frame_t* frame;
+#if RAK3172_CACHE_SIZE > 0
+    if (event.type == RAK3172_EVENT_TX_DONE || event.type == RAK3172_EVENT_SEND_CONFIRMED_OK ||
+        event.type == RAK3172_EVENT_SEND_CONFIRMED_FAILED || event.type == RAK3172_EVENT_RX) {
+        // ADR and MAC commands in the downlink may have changed the data rate, power or channels.
+        invalidateNetworkCache();
+    }
+#endif
+    switch (event.type) {
+        case RAK3172_EVENT_JOINED:
+            _join_lock.take();
+            if (_join_state == LORAWAN_JOIN_WAITING || _join_state == LORAWAN_JOIN_JOINING) {
+                _join_stats.time_to_join_ms = millis() - _join_start;
+            }
+            _join_state = LORAWAN_JOIN_JOINED;
+            _is_joined  = true;
+            _join_lock.give();
+#if RAK3172_CACHE_SIZE > 0
+            // The join assigned a new device address and session keys.
+            invalidateCache();
+#endif
             if (_onJoin) {
-                _onJoin(true);
+                _onJoin(true, _onJoinCtx);
             }
-        }
-        if (res.indexOf("+EVT:JOIN_FAILED") != -1) {
+            flushUplinks();
+            break;
+        case RAK3172_EVENT_JOIN_FAILED:
+            _join_lock.take();
+            _is_joined = false;
+            if (_join_state == LORAWAN_JOIN_JOINING) {
+                joinFailed(millis());
+            } else if (_join_state == LORAWAN_JOIN_JOINED) {
+                _join_state = LORAWAN_JOIN_IDLE;
+                dropUplinks();
+            }
+            _join_lock.give();
             if (_onJoin) {
-                _onJoin(false);
+                _onJoin(false, _onJoinCtx);
             }
-        }
-        if (res.indexOf("+EVT:TX_DONE") != -1) {
+            reportError(event);
+            break;
+        case RAK3172_EVENT_TX_DONE:
             if (_onSend) {
-                // _onSend();
+                _onSend(_onSendCtx);
             }
+            break;
+        case RAK3172_EVENT_SEND_CONFIRMED_OK:
+            if (_onConfirm) {
+                _onConfirm(true, _onConfirmCtx);
+            }
+            break;
+        case RAK3172_EVENT_SEND_CONFIRMED_FAILED:
+            if (_onConfirm) {
+                _onConfirm(false, _onConfirmCtx);
+            }
+            reportError(event);
+            break;
+        case RAK3172_EVENT_LINKCHECK:
+            if (_onLinkCheck) {
+                _onLinkCheck(event.linkcheck, _onLinkCheckCtx);
+            }
+            break;
+        case RAK3172_EVENT_RX:
+            frame = parseFrame(event.line, event.len);
+            if (frame != nullptr && _onReceive) {
+                _onReceive(*frame, _onReceiveCtx);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void RAK3172LoRaWAN::handleTimers()
+{
+    bool attempt = false;
+    bool failed  = false;
+    bool flush;
+    uint32_t now = millis();
+    _join_lock.take();
+    if (_join_state == LORAWAN_JOIN_WAITING && (int32_t)(now - _join_deadline) >= 0) {
+        _join_state    = LORAWAN_JOIN_JOINING;
+        _join_deadline = now + RAK3172_JOIN_TIMEOUT_MS;
+        _join_stats.attempts++;
+        attempt = true;
+    } else if (_join_state == LORAWAN_JOIN_JOINING && (int32_t)(now - _join_deadline) >= 0) {
+        // The result of the attempt was lost.
+        joinFailed(now);
+        failed = true;
+    }
+    flush = _join_state == LORAWAN_JOIN_JOINED && _uplink_count > 0;
+    _join_lock.give();
+    // A single request, retries are scheduled here.
+    if (attempt && !sendCommand("AT+JOIN=1:0:7:0")) {
+        _join_lock.take();
+        if (_join_state == LORAWAN_JOIN_JOINING) {
+            joinFailed(millis());
+            failed = true;
         }
-        if (res.indexOf("+EVT:RX_") != -1) {
-            res.remove(res.length() - 1);
-            parse(res);
-        }
+        _join_lock.give();
+    }
+    if (failed && _onJoin) {
+        _onJoin(false, _onJoinCtx);
+    }
+    if (flush) {
+        flushUplinks();
+    }
+}
+
+void RAK3172LoRaWAN::reportError(const rak3172_event_t& event)
+{
+    char msg[64];
+    if (_onError) {
+        // Strip the "+EVT:" prefix
+        snprintf(msg, sizeof(msg), "%.*s", (int)(event.len - 5), event.line + 5);
+        _onError(msg, _onErrorCtx);
     }
 }
 
+// Trampolines for the callbacks registered with a plain function pointer, passed as context
+static void receiveByValue(const lorawan_frame_t& frame, void* ctx)
+{
+    ((void (*)(lorawan_frame_t))ctx)(frame);
+}
+
+static void sendNoContext(void* ctx)
+{
+    ((void (*)())ctx)();
+}
+
+static void joinNoContext(bool success, void* ctx)
+{
+    ((void (*)(bool))ctx)(success);
+}
+
+static void errorNoContext(const char* error, void* ctx)
+{
+    ((void (*)(char*))ctx)((char*)error);
+}
+
 bool RAK3172LoRaWAN::onReceive(void (*callback)(lorawan_frame_t))
 {
-    _onReceive = callback;
+    return onReceive(callback ? receiveByValue : nullptr, (void*)callback);
+}
+
+bool RAK3172LoRaWAN::onReceive(lorawan_frame_cb_t callback, void* ctx)
+{
+    _onReceive    = callback;
+    _onReceiveCtx = ctx;
     return true;
 }
 
 bool RAK3172LoRaWAN::onSend(void (*callback)())
 {
-    _onSend = callback;
+    return onSend(callback ? sendNoContext : nullptr, (void*)callback);
+}
+
+bool RAK3172LoRaWAN::onSend(lorawan_send_cb_t callback, void* ctx)
+{
+    _onSend    = callback;
+    _onSendCtx = ctx;
     return true;
 }
 
 bool RAK3172LoRaWAN::onJoin(void (*callback)(bool))
 {
-    _onJoin = callback;
+    return onJoin(callback ? joinNoContext : nullptr, (void*)callback);
+}
+
+bool RAK3172LoRaWAN::onJoin(lorawan_result_cb_t callback, void* ctx)
+{
+    _onJoin    = callback;
+    _onJoinCtx = ctx;
     return true;
 }
 
 bool RAK3172LoRaWAN::onError(void (*callback)(char*))
 {
-    _onError = callback;
+    return onError(callback ? errorNoContext : nullptr, (void*)callback);
+}
+
+bool RAK3172LoRaWAN::onError(lorawan_error_cb_t callback, void* ctx)
+{
+    _onError    = callback;
+    _onErrorCtx = ctx;
+    return true;
+}
+
+bool RAK3172LoRaWAN::onConfirm(lorawan_result_cb_t callback, void* ctx)
+{
+    _onConfirm    = callback;
+    _onConfirmCtx = ctx;
+    return true;
+}
+
+bool RAK3172LoRaWAN::onLinkCheck(lorawan_linkcheck_cb_t callback, void* ctx)
+{
+    _onLinkCheck    = callback;
+    _onLinkCheckCtx = ctx;
     return true;
 }
 
+void RAK3172LoRaWAN::setOverflowPolicy(rak3172_overflow_t policy)
+{
+    _frames.setPolicy(policy);
+}
+
+uint32_t RAK3172LoRaWAN::getDroppedFrames()
+{
+    return _frames.dropped();
+}
+
 int RAK3172LoRaWAN::available()
 {
     return _frames.size();
 }
 
+const lorawan_frame_t* RAK3172LoRaWAN::peek()
+{
+    return _frames.front();
+}
+
+void RAK3172LoRaWAN::pop()
+{
+    _frames.pop();
+}
+
+size_t RAK3172LoRaWAN::consume(lorawan_frame_cb_t callback, void* ctx, size_t max)
+{
+    const lorawan_frame_t* frame;
+    size_t count = 0;
+    while (count < max && (frame = _frames.front()) != nullptr) {
+        callback(*frame, ctx);
+        _frames.pop();
+        count++;
+    }
+    return count;
+}
+
 std::vector<lorawan_frame_t> RAK3172LoRaWAN::read()
 {
-    return _frames;
+    std::vector<lorawan_frame_t> frames;
+    if (_frames.front() != nullptr) {
+        size_t count = _frames.size();
+        frames.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            frames.push_back(_frames.at(i));
+        }
+        _frames.release();
+    }
+    return frames;
 }
 
 void RAK3172LoRaWAN::flush()
 {
-    _serial->flush();
+    _transport->flush();
     _frames.clear();
 }
 
@@ -337,14 +871,29 @@ String RAK3172LoRaWAN::getApplicationIdentifier()
     return getCommand("AT+APPEUI=?");
 }
 
+bool RAK3172LoRaWAN::getApplicationIdentifier(uint8_t (&appeui)[8])
+{
+    return getBytes("AT+APPEUI=?", appeui, sizeof(appeui));
+}
+
 String RAK3172LoRaWAN::getApplicationKey()
 {
     return getCommand("AT+APPKEY=?");
 }
 
+bool RAK3172LoRaWAN::getApplicationKey(uint8_t (&appkey)[16])
+{
+    return getBytes("AT+APPKEY=?", appkey, sizeof(appkey));
+}
+
 String RAK3172LoRaWAN::getApplicationSessionKey()
 {
-    return getCommand("AT+APPSKEY?");
+    return getCommand("AT+APPSKEY=?");
+}
+
+bool RAK3172LoRaWAN::getApplicationSessionKey(uint8_t (&appskey)[16])
+{
+    return getBytes("AT+APPSKEY=?", appskey, sizeof(appskey));
 }
 
 String RAK3172LoRaWAN::getNetworkSessionKey()
@@ -352,6 +901,11 @@ String RAK3172LoRaWAN::getNetworkSessionKey()
     return getCommand("AT+NWKSKEY=?");
 }
 
+bool RAK3172LoRaWAN::getNetworkSessionKey(uint8_t (&nwkskey)[16])
+{
+    return getBytes("AT+NWKSKEY=?", nwkskey, sizeof(nwkskey));
+}
+
 String RAK3172LoRaWAN::getNetworkId()
 {
     return getCommand("AT+NETID=?");
@@ -362,21 +916,51 @@ String RAK3172LoRaWAN::getDevAddr()
     return getCommand("AT+DEVADDR=?");
 }
 
+bool RAK3172LoRaWAN::getDevAddr(uint8_t (&devaddr)[4])
+{
+    return getBytes("AT+DEVADDR=?", devaddr, sizeof(devaddr));
+}
+
 String RAK3172LoRaWAN::getDevEUI()
 {
     return getCommand("AT+DEVEUI=?");
 }
 
+bool RAK3172LoRaWAN::getDevEUI(uint8_t (&deveui)[8])
+{
+    return getBytes("AT+DEVEUI=?", deveui, sizeof(deveui));
+}
+
 String RAK3172LoRaWAN::getADR()
 {
     return getCommand("AT+ADR=?");
 }
 
+bool RAK3172LoRaWAN::getADR(bool& enable)
+{
+    uint32_t value;
+    if (!getNumber("AT+ADR=?", &value) || value > 1) {
+        return false;
+    }
+    enable = value != 0;
+    return true;
+}
+
 String RAK3172LoRaWAN::getDCS()
 {
     return getCommand("AT+DCS=?");
 }
 
+bool RAK3172LoRaWAN::getDCS(bool& enable)
+{
+    uint32_t value;
+    if (!getNumber("AT+DCS=?", &value) || value > 1) {
+        return false;
+    }
+    enable = value != 0;
+    return true;
+}
+
 String RAK3172LoRaWAN::getDutyTime()
 {
     return getCommand("AT+DUTYTIME=?");
@@ -384,7 +968,17 @@ String RAK3172LoRaWAN::getDutyTime()
 
 String RAK3172LoRaWAN::getDR()
 {
-    return getCommand("AT+DR?");
+    return getCommand("AT+DR=?");
+}
+
+bool RAK3172LoRaWAN::getDR(uint8_t& dr)
+{
+    uint32_t value;
+    if (!getNumber("AT+DR=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    dr = value;
+    return true;
 }
 
 String RAK3172LoRaWAN::getJoinRX1Delay()
@@ -392,41 +986,121 @@ String RAK3172LoRaWAN::getJoinRX1Delay()
     return getCommand("AT+JN1DL=?");
 }
 
+bool RAK3172LoRaWAN::getJoinRX1Delay(uint8_t& delay)
+{
+    uint32_t value;
+    if (!getNumber("AT+JN1DL=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    delay = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getJoinRX2Delay()
 {
     return getCommand("AT+JN2DL=?");
 }
 
+bool RAK3172LoRaWAN::getJoinRX2Delay(uint8_t& delay)
+{
+    uint32_t value;
+    if (!getNumber("AT+JN2DL=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    delay = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getRX1Delay()
 {
     return getCommand("AT+RX1DL=?");
 }
 
+bool RAK3172LoRaWAN::getRX1Delay(uint8_t& delay)
+{
+    uint32_t value;
+    if (!getNumber("AT+RX1DL=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    delay = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getRX2Delay()
 {
     return getCommand("AT+RX2DL=?");
 }
 
+bool RAK3172LoRaWAN::getRX2Delay(uint8_t& delay)
+{
+    uint32_t value;
+    if (!getNumber("AT+RX2DL=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    delay = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getRX2DR()
 {
     return getCommand("AT+RX2DR=?");
 }
 
+bool RAK3172LoRaWAN::getRX2DR(uint8_t& dr)
+{
+    uint32_t value;
+    if (!getNumber("AT+RX2DR=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    dr = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getRX2Freq()
 {
     return getCommand("AT+RX2FQ=?");
 }
 
+bool RAK3172LoRaWAN::getRX2Freq(uint32_t& freq)
+{
+    uint32_t value;
+    if (!getNumber("AT+RX2FQ=?", &value)) {
+        return false;
+    }
+    freq = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getOutPower()
 {
     return getCommand("AT+TXP=?");
 }
 
+bool RAK3172LoRaWAN::getOutPower(uint8_t& power)
+{
+    uint32_t value;
+    if (!getNumber("AT+TXP=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    power = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getRetransmission()
 {
     return getCommand("AT+RETY=?");
 }
 
+bool RAK3172LoRaWAN::getRetransmission(uint8_t& count)
+{
+    uint32_t value;
+    if (!getNumber("AT+RETY=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    count = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getChannelMask()
 {
     return getCommand("AT+MASK=?");
@@ -437,11 +1111,31 @@ String RAK3172LoRaWAN::getBAND()
     return getCommand("AT+BAND=?");
 }
 
+bool RAK3172LoRaWAN::getBAND(uint8_t& band)
+{
+    uint32_t value;
+    if (!getNumber("AT+BAND=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    band = value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getLinkCheck()
 {
     return getCommand("AT+LINKCHECK=?");
 }
 
+bool RAK3172LoRaWAN::getLinkCheck(lorawan_linkcheck_t& mode)
+{
+    uint32_t value;
+    if (!getNumber("AT+LINKCHECK=?", &value) || value > ALLWAYS_LINKCHECK) {
+        return false;
+    }
+    mode = (lorawan_linkcheck_t)value;
+    return true;
+}
+
 String RAK3172LoRaWAN::getLstMulc()
 {
     return getCommand("AT+LSTMULC=?");
@@ -450,4 +1144,70 @@ String RAK3172LoRaWAN::getLstMulc()
 String RAK3172LoRaWAN::getNetworkState()
 {
     return getCommand("AT+NJS=?");
-}
\ No newline at end of file
+}
+
+bool RAK3172LoRaWAN::getNetworkState(bool& joined)
+{
+    uint32_t value;
+    if (!getNumber("AT+NJS=?", &value) || value > 1) {
+        return false;
+    }
+    joined = value != 0;
+    return true;
+}
+bool RAK3172LoRaWAN::snapshot(lorawan_snapshot_t* snapshot)
+{
+    // Parsed below in this order.
+    static const char* const queries[] = {
+        "AT+VER=?",  "AT+DEVEUI=?", "AT+APPEUI=?", "AT+APPKEY=?",    "AT+DEVADDR=?", "AT+APPSKEY=?", "AT+NWKSKEY=?",
+        "AT+MASK=?", "AT+BAND=?",   "AT+NJM=?",    "AT+NJS=?",       "AT+CLASS=?",   "AT+DR=?",      "AT+ADR=?",
+        "AT+CFM=?",  "AT+DCS=?",    "AT+RETY=?",   "AT+LINKCHECK=?", "AT+TXP=?",     "AT+RX1DL=?",   "AT+RX2DL=?",
+        "AT+JN1DL=?", "AT+JN2DL=?", "AT+RX2DR=?",  "AT+RX2FQ=?",
+    };
+    const size_t count = sizeof(queries) / sizeof(queries[0]);
+    // Sized to the largest field, the session keys.
+    char values[count][sizeof(snapshot->appkey)];
+    rak3172_result_t result;
+    size_t answered = getCommands(queries, count, values[0], sizeof(values[0]), RAK3172_COMMAND_TIMEOUT, &result);
+    size_t i        = 0;
+    uint8_t errors  = 0;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    errors += !copyString(snapshot->version, sizeof(snapshot->version), values[i++]);
+    errors += !copyString(snapshot->deveui, sizeof(snapshot->deveui), values[i++]);
+    errors += !copyString(snapshot->appeui, sizeof(snapshot->appeui), values[i++]);
+    errors += !copyString(snapshot->appkey, sizeof(snapshot->appkey), values[i++]);
+    errors += !copyString(snapshot->devaddr, sizeof(snapshot->devaddr), values[i++]);
+    errors += !copyString(snapshot->appskey, sizeof(snapshot->appskey), values[i++]);
+    errors += !copyString(snapshot->nwkskey, sizeof(snapshot->nwkskey), values[i++]);
+    errors += !copyString(snapshot->mask, sizeof(snapshot->mask), values[i++]);
+    snapshot->band      = strtoul(values[i++], nullptr, 10);
+    snapshot->join_mode = values[i++][0] == '0' ? ABP : OTAA;
+    snapshot->joined    = values[i++][0] == '1';
+    switch (values[i++][0]) {
+        case 'B':
+            snapshot->dev_class = CLASS_B;
+            break;
+        case 'C':
+            snapshot->dev_class = CLASS_C;
+            break;
+        default:
+            snapshot->dev_class = CLASS_A;
+            break;
+    }
+    snapshot->dr             = strtoul(values[i++], nullptr, 10);
+    snapshot->adr            = values[i++][0] == '1';
+    snapshot->confirm        = values[i++][0] == '1';
+    snapshot->dcs            = values[i++][0] == '1';
+    snapshot->retransmission = strtoul(values[i++], nullptr, 10);
+    snapshot->linkcheck      = (lorawan_linkcheck_t)strtoul(values[i++], nullptr, 10);
+    snapshot->tx_power       = strtoul(values[i++], nullptr, 10);
+    snapshot->rx1_delay      = strtoul(values[i++], nullptr, 10);
+    snapshot->rx2_delay      = strtoul(values[i++], nullptr, 10);
+    snapshot->join_rx1_delay = strtoul(values[i++], nullptr, 10);
+    snapshot->join_rx2_delay = strtoul(values[i++], nullptr, 10);
+    snapshot->rx2_dr         = strtoul(values[i++], nullptr, 10);
+    snapshot->rx2_freq       = strtoul(values[i++], nullptr, 10);
+    snapshot->errors         = count - answered + errors;
+    return result != RAK3172_RESULT_TIMEOUT;
+}
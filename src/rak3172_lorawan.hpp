@@ -11,6 +11,7 @@
 #include "Stream.h"
 #include <vector>
 #include "rak3172_common.hpp"
+#include "rak3172_queue.hpp"
 
 /**
  * @def EU433
@@ -117,6 +118,78 @@
  */
 #define AS923_4 "8-4"
 
+/**
+ * @def RAK3172_UPLINK_QUEUE_SIZE
+ * @brief Number of uplinks `RAK3172LoRaWAN::send()` holds while `beginJoin()` is joining.
+ *
+ * When the queue is full the oldest uplink is dropped.
+ */
+#ifndef RAK3172_UPLINK_QUEUE_SIZE
+#define RAK3172_UPLINK_QUEUE_SIZE 4
+#endif
+
+/**
+ * @def RAK3172_UPLINK_SIZE
+ * @brief Largest payload in bytes that can be held until the device has joined.
+ */
+#ifndef RAK3172_UPLINK_SIZE
+#define RAK3172_UPLINK_SIZE 242
+#endif
+
+/**
+ * @def RAK3172_UPLINK_RETRY_MIN_MS
+ * @brief First delay before a held uplink rejected with `AT_BUSY_ERROR` is sent again.
+ *
+ * The delay doubles for every consecutive rejection up to `RAK3172_UPLINK_RETRY_MAX_MS`.
+ */
+#ifndef RAK3172_UPLINK_RETRY_MIN_MS
+#define RAK3172_UPLINK_RETRY_MIN_MS 2000
+#endif
+
+/**
+ * @def RAK3172_UPLINK_RETRY_MAX_MS
+ * @brief Upper bound of the retry delay of a busy held uplink.
+ *
+ * The default covers the 1% duty cycle of a worst-case uplink of 1.5 s time on air.
+ */
+#ifndef RAK3172_UPLINK_RETRY_MAX_MS
+#define RAK3172_UPLINK_RETRY_MAX_MS 150000
+#endif
+
+/**
+ * @def RAK3172_JOIN_TIMEOUT_MS
+ * @brief Time to wait for `+EVT:JOINED` or `+EVT:JOIN_FAILED` before an attempt counts as failed.
+ */
+#ifndef RAK3172_JOIN_TIMEOUT_MS
+#define RAK3172_JOIN_TIMEOUT_MS 20000
+#endif
+
+/**
+ * @def RAK3172_JOIN_AIRTIME_MS
+ * @brief Time on air of one join request used to enforce the join duty cycle.
+ *
+ * The default is the worst case, a 23-byte join request at SF12/125 kHz.
+ */
+#ifndef RAK3172_JOIN_AIRTIME_MS
+#define RAK3172_JOIN_AIRTIME_MS 1500
+#endif
+
+/**
+ * @def RAK3172_JOIN_BACKOFF_MIN_MS
+ * @brief Window of the random delay before the first join request, and first retry delay.
+ */
+#ifndef RAK3172_JOIN_BACKOFF_MIN_MS
+#define RAK3172_JOIN_BACKOFF_MIN_MS 10000
+#endif
+
+/**
+ * @def RAK3172_JOIN_BACKOFF_MAX_MS
+ * @brief Upper bound of the exponential retry delay; the join duty cycle may still require more.
+ */
+#ifndef RAK3172_JOIN_BACKOFF_MAX_MS
+#define RAK3172_JOIN_BACKOFF_MAX_MS 3600000
+#endif
+
 /**
  * @brief Enumeration for LoRaWAN join modes.
  */
@@ -150,6 +223,47 @@ typedef enum {
     ERROR = 0 /**< Generic error code */
 } lorawan_error_t;
 
+/**
+ * @brief States of the join state machine, see `RAK3172LoRaWAN::beginJoin()`.
+ */
+typedef enum {
+    LORAWAN_JOIN_IDLE = 0, /**< No join started */
+    LORAWAN_JOIN_WAITING,  /**< Waiting for the time of the next join request */
+    LORAWAN_JOIN_JOINING,  /**< Join request sent, waiting for its result */
+    LORAWAN_JOIN_JOINED,   /**< Joined the network */
+    LORAWAN_JOIN_FAILED    /**< Gave up after the maximum number of attempts */
+} lorawan_join_state_t;
+
+/**
+ * @brief Join metrics, see `RAK3172LoRaWAN::getJoinStats()`.
+ */
+typedef struct {
+    uint32_t attempts;        /**< Join requests sent since `beginJoin()` */
+    uint32_t failures;        /**< Join requests that failed or timed out */
+    uint32_t time_to_join_ms; /**< Time from `beginJoin()` to `+EVT:JOINED`, 0 until joined */
+    uint32_t next_attempt_ms; /**< Time left before the next join request, 0 unless waiting */
+    uint32_t uplinks_held;    /**< Uplinks currently held until the device has joined */
+    uint32_t uplinks_dropped; /**< Held uplinks dropped: queue full, sending failed or join stopped */
+} lorawan_join_stats_t;
+
+/**
+ * @brief Outcome of `RAK3172LoRaWAN::send()`.
+ */
+typedef enum {
+    LORAWAN_SEND_ERROR = 0, /**< The uplink was neither sent nor held */
+    LORAWAN_SEND_OK,        /**< The module accepted the uplink */
+    LORAWAN_SEND_HELD       /**< The uplink is held until the device has joined */
+} lorawan_send_status_t;
+
+/**
+ * @brief Uplink held by `RAK3172LoRaWAN::send()` until the device has joined.
+ */
+typedef struct {
+    uint8_t port;                      /**< Port number */
+    uint16_t len;                      /**< Length of the payload */
+    uint8_t data[RAK3172_UPLINK_SIZE]; /**< Payload data */
+} lorawan_uplink_t;
+
 /**
  * @brief Structure representing LoRaWAN received frame information.
  */
@@ -162,8 +276,82 @@ typedef struct {
     char payload[500]; /**< Payload data received (up to 500 bytes) */
 } lorawan_frame_t;
 
+/**
+ * @brief Callback type used by `RAK3172LoRaWAN::consume()`.
+ *
+ * @param frame The received frame. The reference is only valid during the call.
+ * @param ctx The user pointer passed to `consume()`.
+ */
+typedef void (*lorawan_frame_cb_t)(const lorawan_frame_t& frame, void* ctx);
+
+/**
+ * @brief Callback type used by `RAK3172LoRaWAN::onSend()`.
+ *
+ * @param ctx The user pointer passed at registration.
+ */
+typedef void (*lorawan_send_cb_t)(void* ctx);
+
+/**
+ * @brief Callback type used by `RAK3172LoRaWAN::onJoin()` and `RAK3172LoRaWAN::onConfirm()`.
+ *
+ * @param success `true` if the network joined or acknowledged the uplink.
+ * @param ctx The user pointer passed at registration.
+ */
+typedef void (*lorawan_result_cb_t)(bool success, void* ctx);
+
+/**
+ * @brief Callback type used by `RAK3172LoRaWAN::onError()`.
+ *
+ * @param error The error event without its `+EVT:` prefix. Only valid during the call.
+ * @param ctx The user pointer passed at registration.
+ */
+typedef void (*lorawan_error_cb_t)(const char* error, void* ctx);
+
+/**
+ * @brief Callback type used by `RAK3172LoRaWAN::onLinkCheck()`.
+ *
+ * @param result The link check result. Only valid during the call.
+ * @param ctx The user pointer passed at registration.
+ */
+typedef void (*lorawan_linkcheck_cb_t)(const rak3172_linkcheck_t& result, void* ctx);
+
+/**
+ * @brief LoRaWAN configuration and state of the module, see `RAK3172LoRaWAN::snapshot()`.
+ *
+ * Keys, EUIs and addresses are kept as the hexadecimal strings reported by the module.
+ */
+typedef struct {
+    char version[32];              /**< Firmware version (`AT+VER`) */
+    char deveui[17];               /**< Device EUI (`AT+DEVEUI`) */
+    char appeui[17];               /**< Application EUI (`AT+APPEUI`) */
+    char appkey[33];               /**< Application key (`AT+APPKEY`) */
+    char devaddr[9];               /**< Device address (`AT+DEVADDR`) */
+    char appskey[33];              /**< Application session key (`AT+APPSKEY`) */
+    char nwkskey[33];              /**< Network session key (`AT+NWKSKEY`) */
+    char mask[5];                  /**< Channel mask (`AT+MASK`), empty on bands without one */
+    uint8_t band;                  /**< Band number (`AT+BAND`), see `RAK3172LoRaWAN::getBAND()` */
+    lorawan_join_mode_t join_mode; /**< Join mode (`AT+NJM`) */
+    bool joined;                   /**< Network joined (`AT+NJS`) */
+    lorawan_dev_class_t dev_class; /**< Device class (`AT+CLASS`) */
+    uint8_t dr;                    /**< Data rate (`AT+DR`) */
+    bool adr;                      /**< Adaptive data rate enabled (`AT+ADR`) */
+    bool confirm;                  /**< Confirmed uplinks (`AT+CFM`) */
+    bool dcs;                      /**< Duty cycle enforced (`AT+DCS`) */
+    lorawan_linkcheck_t linkcheck; /**< Link check mode (`AT+LINKCHECK`) */
+    uint8_t retransmission;        /**< Retransmissions of confirmed uplinks (`AT+RETY`) */
+    uint8_t tx_power;              /**< TX power index (`AT+TXP`) */
+    uint16_t rx1_delay;            /**< RX1 window delay in seconds (`AT+RX1DL`) */
+    uint16_t rx2_delay;            /**< RX2 window delay in seconds (`AT+RX2DL`) */
+    uint16_t join_rx1_delay;       /**< Join accept RX1 delay in seconds (`AT+JN1DL`) */
+    uint16_t join_rx2_delay;       /**< Join accept RX2 delay in seconds (`AT+JN2DL`) */
+    uint8_t rx2_dr;                /**< RX2 window data rate (`AT+RX2DR`) */
+    uint32_t rx2_freq;             /**< RX2 window frequency in Hz (`AT+RX2FQ`) */
+    uint8_t errors;                /**< Queries answered with an error (e.g. `AT+MASK` on EU868) or too long */
+} lorawan_snapshot_t;
+
 class RAK3172LoRaWAN : public RAK3172 {
 public:
+#if defined RAK3172_USE_FREERTOS
     /**
      * @brief Initializes the RAK3172 LoRaWAN module.
      *
@@ -183,6 +371,19 @@ public:
      *         false otherwise.
      */
     bool init(HardwareSerial* serial = &Serial2, int rx = 16, int tx = 17, rak3172_bps_t baudRate = RAK3172_BPS_115200);
+#endif
+
+    /**
+     * @brief Initializes the module on an already opened transport.
+     *
+     * Performs the same configuration as the `HardwareSerial` overload, e.g. over a
+     * `RAK3172PosixTransport` on a Linux host.
+     *
+     * @param transport The transport connected to the module.
+     * @return true if the initialization commands were successfully sent;
+     *         false otherwise.
+     */
+    bool init(RAK3172Transport* transport);
 
     /**
      * @brief Sets the global application identifier (AppEUI) for the RAK3172 LoRaWAN module.
@@ -200,6 +401,14 @@ public:
      * @return True if the command to set the application identifier was
      *         successfully sent; false if the identifier is invalid.
      */
+    bool setApplicationIdentifier(const char* identifier);
+
+    /**
+     * @brief Sets the AppEUI from a `String`, see `setApplicationIdentifier(const char*)`.
+     *
+     * @param identifier The 8-character application identifier.
+     * @return True if the command was successfully sent; false otherwise.
+     */
     bool setApplicationIdentifier(const String& identifier);
 
     /**
@@ -218,6 +427,14 @@ public:
      * @return True if the command to set the application key was
      *         successfully sent; false if the key is invalid.
      */
+    bool setApplicationKey(const char* key);
+
+    /**
+     * @brief Sets the AppKey from a `String`, see `setApplicationKey(const char*)`.
+     *
+     * @param key The 16-character application key.
+     * @return True if the command was successfully sent; false otherwise.
+     */
     bool setApplicationKey(const String& key);
 
     /**
@@ -236,6 +453,14 @@ public:
      * @return True if the command to set the application session key was
      *         successfully sent; false if the key is invalid.
      */
+    bool setApplicationSessionKey(const char* key);
+
+    /**
+     * @brief Sets the AppSKey from a `String`, see `setApplicationSessionKey(const char*)`.
+     *
+     * @param key The 16-character application session key.
+     * @return True if the command was successfully sent; false otherwise.
+     */
     bool setApplicationSessionKey(const String& key);
 
     /**
@@ -254,6 +479,14 @@ public:
      * @return True if the command to set the network session key was
      *         successfully sent; false if the key is invalid.
      */
+    bool setNetworkSessionKey(const char* key);
+
+    /**
+     * @brief Sets the NwkSKey from a `String`, see `setNetworkSessionKey(const char*)`.
+     *
+     * @param key The 16-character network session key.
+     * @return True if the command was successfully sent; false otherwise.
+     */
     bool setNetworkSessionKey(const String& key);
 
     /**
@@ -272,6 +505,14 @@ public:
      * @return True if the command to set the device address was
      *         successfully sent; false if the address is invalid.
      */
+    bool setDevAddr(const char* addr);
+
+    /**
+     * @brief Sets the DevAddr from a `String`, see `setDevAddr(const char*)`.
+     *
+     * @param addr The 4-character device address.
+     * @return True if the command was successfully sent; false otherwise.
+     */
     bool setDevAddr(const String& addr);
 
     /**
@@ -290,6 +531,14 @@ public:
      * @return True if the command to set the DevEUI was
      *         successfully sent; false if the EUI is invalid.
      */
+    bool setDevEUI(const char* eui);
+
+    /**
+     * @brief Sets the DevEUI from a `String`, see `setDevEUI(const char*)`.
+     *
+     * @param eui The 8-character global end-device identifier.
+     * @return True if the command was successfully sent; false otherwise.
+     */
     bool setDevEUI(const String& eui);
 
     /**
@@ -317,7 +566,16 @@ public:
      * @return True if both commands to set the band and channel mask
      *         were successfully sent; false otherwise.
      */
-    bool setBAND(String band, String channel_mask = "");
+    bool setBAND(const char* band, const char* channel_mask = "");
+
+    /**
+     * @brief Sets the frequency band and channel mask from `String`s, see `setBAND(const char*, const char*)`.
+     *
+     * @param band The frequency band to be set.
+     * @param channel_mask The hexadecimal channel mask (only for CN470, US915, AU915).
+     * @return True if the command(s) were successfully sent; false otherwise.
+     */
+    bool setBAND(const String& band, const String& channel_mask = "");
 
     /**
      * @brief Configures the device for Over-The-Air Activation (OTAA) for the RAK3172 LoRaWAN module.
@@ -344,7 +602,17 @@ public:
      * @return True if all commands to configure OTAA were successfully sent;
      *         false otherwise.
      */
-    bool setOTAA(String deveui, String appeui, String appkey);
+    bool setOTAA(const char* deveui, const char* appeui, const char* appkey);
+
+    /**
+     * @brief Configures OTAA from `String`s, see `setOTAA(const char*, const char*, const char*)`.
+     *
+     * @param deveui The device EUI.
+     * @param appeui The application EUI.
+     * @param appkey The application key.
+     * @return True if all commands were successfully sent; false otherwise.
+     */
+    bool setOTAA(const String& deveui, const String& appeui, const String& appkey);
 
     /**
      * @brief Configures the device for Activation By Personalization (ABP) for the RAK3172 LoRaWAN module.
@@ -371,7 +639,17 @@ public:
      * @return True if all commands to configure ABP were successfully sent;
      *         false otherwise.
      */
-    bool setABP(String devaddr, String nwkskey, String appskey);
+    bool setABP(const char* devaddr, const char* nwkskey, const char* appskey);
+
+    /**
+     * @brief Configures ABP from `String`s, see `setABP(const char*, const char*, const char*)`.
+     *
+     * @param devaddr The device address.
+     * @param nwkskey The network session key.
+     * @param appskey The application session key.
+     * @return True if all commands were successfully sent; false otherwise.
+     */
+    bool setABP(const String& devaddr, const String& nwkskey, const String& appskey);
 
     /**
      * @brief Configures multicast settings by adding a new multicast group and its parameters.
@@ -400,12 +678,26 @@ public:
      * @param periodicity A uint8_t representing the periodicity of the multicast
      *                    messages.
      *
-     * @return The constructed command string to add the new multicast group
-     *         and its parameters. This should then be sent to the device
-     *         for execution.
+     * @return True if the command to add the multicast group was successfully
+     *         sent; false otherwise.
      */
-    bool setADDMulc(String mode, String devaddr, String nwkskey, String appskey, uint32_t freq, uint8_t dataRate,
-                    uint8_t periodicity);
+    bool setADDMulc(const char* mode, const char* devaddr, const char* nwkskey, const char* appskey, uint32_t freq,
+                    uint8_t dataRate, uint8_t periodicity);
+
+    /**
+     * @brief Adds a multicast group from `String` parameters, see `setADDMulc(const char*, ...)`.
+     *
+     * @param mode The multicast mode.
+     * @param devaddr The multicast device address.
+     * @param nwkskey The multicast network session key.
+     * @param appskey The multicast application session key.
+     * @param freq The multicast frequency.
+     * @param dataRate The multicast data rate.
+     * @param periodicity The ping slot periodicity (Class B only).
+     * @return True if the command was successfully sent; false otherwise.
+     */
+    bool setADDMulc(const String& mode, const String& devaddr, const String& nwkskey, const String& appskey,
+                    uint32_t freq, uint8_t dataRate, uint8_t periodicity);
 
     /**
      * @brief Deletes a configured multicast group using its device address.
@@ -421,11 +713,18 @@ public:
      * @param devaddr A String representing the device address (DevAddr)
      *                 of the multicast group to be removed.
      *
-     * @return The constructed command string to delete the specified
-     *         multicast group. This should then be sent to the device
-     *         for execution.
+     * @return True if the command to delete the multicast group was
+     *         successfully sent; false otherwise.
      */
-    bool detelRmvmulc(String devaddr);
+    bool detelRmvmulc(const char* devaddr);
+
+    /**
+     * @brief Removes a multicast group from a `String` address, see `detelRmvmulc(const char*)`.
+     *
+     * @param devaddr The multicast device address.
+     * @return True if the command was successfully sent; false otherwise.
+     */
+    bool detelRmvmulc(const String& devaddr);
 
     /**
      * @brief Configures the link check settings for the RAK3172 LoRaWAN module.
@@ -801,6 +1100,62 @@ public:
      */
     bool join(bool enable = true, bool boot_auto_join = false, uint8_t retry_interval = 10, uint8_t retry_times = 8);
 
+    /**
+     * @brief Starts joining the network in the background (OTAA).
+     *
+     * The function returns immediately; the join is driven by `update()` or by the task
+     * started with `beginReceive()`:
+     * - The first join request is sent after a random delay of up to
+     *   `RAK3172_JOIN_BACKOFF_MIN_MS`, so devices powered up together do not all transmit
+     *   at the same time.
+     * - Each attempt sends a single join request (`AT+JOIN=1:0:7:0`) and waits for
+     *   `+EVT:JOINED` or `+EVT:JOIN_FAILED`, at most `RAK3172_JOIN_TIMEOUT_MS`.
+     * - After a failure the next attempt is delayed exponentially from
+     *   `RAK3172_JOIN_BACKOFF_MIN_MS` to `RAK3172_JOIN_BACKOFF_MAX_MS`, but never less than
+     *   the join duty cycle of the LoRaWAN specification allows for a request of
+     *   `RAK3172_JOIN_AIRTIME_MS`: 1% during the first hour, 0.1% until the 11th hour and
+     *   0.01% afterwards. A random jitter of up to half the delay is added.
+     *
+     * While the join is in progress `send()` holds the uplinks and sends them once the
+     * device has joined. The progress is reported by `getJoinState()`, `getJoinStats()`
+     * and `onJoin()`, which is called for every attempt.
+     *
+     * @note Calling this function again restarts the join and clears the join metrics.
+     *
+     * @param max_attempts Number of join requests before giving up, 0 to retry forever.
+     * @return `true` if the join was started, `false` if the device is not in OTAA mode.
+     */
+    bool beginJoin(uint32_t max_attempts = 0);
+
+    /**
+     * @brief Stops the join started by `beginJoin()`.
+     *
+     * An attempt already sent is not cancelled, but its result no longer triggers a retry.
+     * Held uplinks are dropped and counted in `lorawan_join_stats_t::uplinks_dropped`, so
+     * later calls to `send()` transmit immediately. The same happens when the join gives up
+     * in `LORAWAN_JOIN_FAILED`.
+     */
+    void cancelJoin();
+
+    /**
+     * @brief Returns the state of the join state machine.
+     */
+    lorawan_join_state_t getJoinState();
+
+    /**
+     * @brief Returns `true` once `+EVT:JOINED` has been received.
+     *
+     * Unlike `getNetworkState()`, no command is sent to the module.
+     */
+    bool isJoined();
+
+    /**
+     * @brief Reads the join metrics, see `lorawan_join_stats_t`.
+     *
+     * @param stats Receives the metrics.
+     */
+    void getJoinStats(lorawan_join_stats_t* stats);
+
     /**
      * @brief Sets the retransmission count for confirmed packets.
      *
@@ -853,11 +1208,24 @@ public:
      * @param data The payload string to be sent, which will be converted to
      *             hexadecimal format.
      * @param port An integer indicating the port number on which to send the data.
+     * @param status Optional, receives the outcome, see `send(const uint8_t*, size_t, int, lorawan_send_status_t*)`.
      *
      * @return The length of the original data if the command was successfully sent;
-     *         0 if there was an error during the command execution.
+     *         0 if the uplink was held or there was an error during the command execution.
      */
-    size_t send(String data, int port = 1);
+    size_t send(String data, int port = 1, lorawan_send_status_t* status = nullptr);
+
+    /**
+     * @brief Sends a null-terminated string, see `send(String, int)`.
+     *
+     * @param data The null-terminated string to be sent.
+     * @param port An integer indicating the port number on which to send the data.
+     * @param status Optional, receives the outcome, see `send(const uint8_t*, size_t, int, lorawan_send_status_t*)`.
+     *
+     * @return The length of the string if the command was successfully sent;
+     *         0 if the uplink was held or there was an error during the command execution.
+     */
+    size_t send(const char* data, int port = 1, lorawan_send_status_t* status = nullptr);
 
     /**
      * @brief Sends binary data over a specified port using the RAK3172 LoRaWAN module.
@@ -877,14 +1245,53 @@ public:
      *       for sending non-text data, such as sensor readings or configuration
      *       settings that are represented in binary form.
      *
+     * @note The payload is hex-encoded in small chunks while it is written to the
+     *       serial interface, so no copy of the encoded command is kept in RAM.
+     *
      * @param buf A pointer to the binary data (byte array) to be sent.
      * @param size The size of the binary data in bytes.
      * @param port An integer indicating the port number on which to send the data.
      *
+     * @param status Optional, receives `LORAWAN_SEND_OK`, `LORAWAN_SEND_HELD` or `LORAWAN_SEND_ERROR`.
+     *
+     * @note While `beginJoin()` has not joined yet, the uplink is held and sent once the
+     *       device has joined, see `RAK3172_UPLINK_QUEUE_SIZE`. This is reported as
+     *       `LORAWAN_SEND_HELD` in `status`.
+     *
      * @return The size of the original data if the command was successfully sent;
-     *         0 if there was an error during the command execution.
+     *         0 if the uplink was held, there was an error during the command execution
+     *         or the payload is too large to be held.
      */
-    size_t send(const uint8_t* buf, size_t size, int port = 1);
+    size_t send(const uint8_t* buf, size_t size, int port = 1, lorawan_send_status_t* status = nullptr);
+
+#if defined RAK3172_USE_FREERTOS
+    /**
+     * @brief Queues an uplink of binary data and returns without waiting for the module.
+     *
+     * The `AT+SEND` command is built immediately and executed by the worker task
+     * started with `beginAsync()`, which then calls `callback` with its final result.
+     *
+     * @param buf A pointer to the binary data (byte array) to be sent.
+     * @param size The size of the binary data in bytes.
+     * @param port An integer indicating the port number on which to send the data.
+     * @param callback Completion callback, or `nullptr` to fire and forget.
+     * @param ctx User context pointer passed to `callback`.
+     * @return `true` if the uplink was queued, `false` otherwise.
+     */
+    bool sendAsync(const uint8_t* buf, size_t size, int port = 1, rak3172_command_cb_t callback = nullptr,
+                   void* ctx = nullptr);
+
+    /**
+     * @brief Queues an uplink of binary data and reports its completion through a future.
+     *
+     * @param buf A pointer to the binary data (byte array) to be sent.
+     * @param size The size of the binary data in bytes.
+     * @param port An integer indicating the port number on which to send the data.
+     * @param future Caller-owned completion state, see `sendCommandAsync()`.
+     * @return `true` if the uplink was queued, `false` otherwise.
+     */
+    bool sendAsync(const uint8_t* buf, size_t size, int port, rak3172_future_t* future);
+#endif
 
     /**
      * @brief Parses a received LoRaWAN frame and extracts relevant information.
@@ -911,35 +1318,44 @@ public:
      */
     void parse(String frame);
 
+    /**
+     * @brief Parses a received "+EVT:RX_" line in a single pass.
+     *
+     * The fields are read in place from `line` and the hex payload is decoded straight
+     * into the `payload` array of the new frame, so no intermediate strings are created.
+     * Every field is scanned within `len`, so `line` does not need to be null-terminated.
+     * Lines that are malformed or whose payload is not valid hex are discarded before a
+     * queue slot is reserved, so they never evict a queued frame.
+     *
+     * @param line Pointer to the received line.
+     * @param len The length of the line in characters.
+     */
+    void parse(const char* line, size_t len);
+
     /**
      * @brief Updates and processes incoming data from the LoRaWAN serial interface.
      *
      * This function is designed to periodically check for new data from the LoRaWAN
-     * module and handle various events based on the received response. It reads data
-     * from the serial interface, processes specific event messages (such as join status,
-     * transmission status, and received messages), and invokes corresponding callback
-     * functions if they are set.
-     *
-     * The function reads a line of data terminated by a newline character and checks
-     * for specific event keywords. It processes the following events:
-     * - **+EVT:JOINED**: Indicates that the device has successfully joined the LoRaWAN network.
-     * - **+EVT:JOIN_FAILED**: Indicates that the device failed to join the network.
-     * - **+EVT:TX_DONE**: Indicates that a transmission has been completed.
-     * - **+EVT:RX_**: Indicates that a received message is available, which is then parsed.
-     *
-     * If a corresponding event is found, the appropriate callback function (if set) is invoked:
-     * - `_onJoin`: Called with `true` if the device successfully joined the network, `false` if it failed.
-     * - `_onSend`: Placeholder for any send completion handler (currently commented out).
-     * - `parse`: Processes the received frame (if a "RX_" event is detected).
-     *
-     * @note This function requires a mutex (_serial_mutex) to safely access the serial
-     *       interface and ensure that other tasks or processes do not interfere during
-     *       the data read operation. This is particularly important in multi-threaded
-     *       or multi-core environments (e.g., FreeRTOS).
-     *
-     * @note The event handling sections (such as +EVT:TX_DONE) are placeholders
-     *       for future implementations, where actions may be taken upon completion
-     *       of a transmission, or additional event types may be added.
+     * module and handle various events based on the received response. It drains the
+     * bytes already received on the serial interface, without waiting for more, and
+     * dispatches every complete event line, including the events that arrived while a
+     * command was waiting for its response.
+     *
+     * Every event line is decoded once by `parseEvent()` and the matching callback (if set)
+     * is invoked:
+     * - **+EVT:JOINED** / **+EVT:JOIN_FAILED...**: `onJoin()` with `true` or `false`; a
+     *   failed join is also reported to `onError()`. Both also advance `beginJoin()`.
+     * - **+EVT:TX_DONE**: `onSend()`.
+     * - **+EVT:SEND_CONFIRMED_OK** / **+EVT:SEND_CONFIRMED_FAILED...**: `onConfirm()` with
+     *   `true` or `false`; a failure is also reported to `onError()`.
+     * - **+EVT:LINKCHECK:...**: `onLinkCheck()` with the decoded result.
+     * - **+EVT:RX_...**: the frame is parsed and queued, then passed to `onReceive()`.
+     *
+     * All events, including unknown ones, are finally passed to `onEvent()`.
+     *
+     * @note The serial interface is read by a single demultiplexer shared with `sendCommand()`,
+     *       which routes command responses to the waiting command and event lines to this
+     *       function, so neither side can swallow the other's data.
      */
     void update();
 
@@ -953,7 +1369,7 @@ public:
      *
      * The registered callback is stored and will be called whenever a frame is received
      * and successfully parsed by the system (typically during the processing of an
-     * event like `+EVT:RX_`).
+     * event like `+EVT:RX_`). The frame also stays in the receive queue.
      *
      * @note The callback function should be designed to handle the incoming
      *       `lorawan_frame_t` structure, which contains information about the
@@ -962,6 +1378,9 @@ public:
      *       data processing or triggering other application logic, based on the
      *       frame content.
      *
+     * @note The frame is copied for every call; prefer
+     *       `onReceive(lorawan_frame_cb_t, void*)`, which passes it by reference.
+     *
      * @param callback A pointer to the callback function that will be invoked when
      *                 a frame is received. The callback should have the following signature:
      *                 `void callback(lorawan_frame_t frame);`
@@ -970,6 +1389,19 @@ public:
      */
     bool onReceive(void (*callback)(lorawan_frame_t));
 
+    /**
+     * @brief Registers a callback receiving each received frame by reference.
+     *
+     * Same as `onReceive(void (*)(lorawan_frame_t))`, without copying the frame and with
+     * a user pointer, so the handler needs no global state.
+     *
+     * @param callback The callback, or `nullptr` to remove it. The frame reference is only
+     *        valid during the call.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onReceive(lorawan_frame_cb_t callback, void* ctx);
+
     /**
      * @brief Registers a callback function to handle transmission completion events.
      *
@@ -994,6 +1426,16 @@ public:
      */
     bool onSend(void (*callback)());
 
+    /**
+     * @brief Registers a transmission completion callback with a user pointer, see
+     *        `onSend(void (*)())`.
+     *
+     * @param callback The callback, or `nullptr` to remove it.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onSend(lorawan_send_cb_t callback, void* ctx);
+
     /**
      * @brief Registers a callback function to handle join status events.
      *
@@ -1019,6 +1461,15 @@ public:
      */
     bool onJoin(void (*callback)(bool));
 
+    /**
+     * @brief Registers a join status callback with a user pointer, see `onJoin(void (*)(bool))`.
+     *
+     * @param callback The callback, or `nullptr` to remove it.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onJoin(lorawan_result_cb_t callback, void* ctx);
+
     /**
      * @brief Registers a callback function to handle error events.
      *
@@ -1028,7 +1479,8 @@ public:
      * error type or message.
      *
      * The registered callback is stored and will be called with a character pointer
-     * that points to a string describing the error.
+     * that points to a string describing the error: the event line without its `+EVT:`
+     * prefix, e.g. `JOIN_FAILED_RX_TIMEOUT` or `SEND_CONFIRMED_FAILED(4)`.
      *
      * @note The callback function should be designed to handle the error message
      *       appropriately, such as logging the error, notifying the user, or
@@ -1042,6 +1494,60 @@ public:
      */
     bool onError(void (*callback)(char*));
 
+    /**
+     * @brief Registers an error callback with a user pointer, see `onError(void (*)(char*))`.
+     *
+     * @param callback The callback, or `nullptr` to remove it.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onError(lorawan_error_cb_t callback, void* ctx);
+
+    /**
+     * @brief Registers a callback receiving the outcome of confirmed uplinks.
+     *
+     * The callback is called with `true` on `+EVT:SEND_CONFIRMED_OK` and with `false` on
+     * `+EVT:SEND_CONFIRMED_FAILED`, i.e. when the network did not acknowledge the uplink
+     * after all retransmissions.
+     *
+     * @param callback The callback, or `nullptr` to remove it.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onConfirm(lorawan_result_cb_t callback, void* ctx = nullptr);
+
+    /**
+     * @brief Registers a callback receiving link check results.
+     *
+     * The callback is called on `+EVT:LINKCHECK`, which the module reports after an
+     * uplink when link checks are enabled with `setLinkCheck()`.
+     *
+     * @param callback The callback, or `nullptr` to remove it.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onLinkCheck(lorawan_linkcheck_cb_t callback, void* ctx = nullptr);
+
+    /**
+     * @brief Selects what happens to a received frame when the frame queue is full.
+     *
+     * The queue holds `RAK3172_FRAME_QUEUE_SIZE` frames. By default the oldest frame
+     * is discarded to make room for the new one.
+     *
+     * @note `RAK3172_OVERFLOW_BLOCK` stalls `update()` until a frame is consumed, so
+     *       it must only be used when the frames are read from a different task.
+     *
+     * @param policy The overflow policy.
+     */
+    void setOverflowPolicy(rak3172_overflow_t policy);
+
+    /**
+     * @brief Returns the number of received frames discarded because the queue was full.
+     *
+     * @return The number of dropped frames since the object was created.
+     */
+    uint32_t getDroppedFrames();
+
     /**
      * @brief Returns the number of available LoRaWAN frames in the buffer.
      *
@@ -1058,6 +1564,41 @@ public:
      */
     int available();
 
+    /**
+     * @brief Returns the oldest received LoRaWAN frame without removing it.
+     *
+     * The frame is not copied; the pointer refers to the slot inside the frame queue
+     * and stays valid until `pop()` or `flush()` is called. Frames that arrive in the
+     * meantime are appended behind it.
+     *
+     * @note The frame queue is a lock-free single-producer/single-consumer ring, so
+     *       `update()` may run in its own task while one other task reads frames.
+     *       A peeked frame is never overwritten: if the queue overflows before
+     *       `pop()`, the newly received frame is dropped instead.
+     *
+     * @return Pointer to the oldest frame, or nullptr if no frame is available.
+     */
+    const lorawan_frame_t* peek();
+
+    /**
+     * @brief Removes the oldest received frame (the one returned by `peek()`).
+     */
+    void pop();
+
+    /**
+     * @brief Hands queued frames to a callback and removes exactly those frames.
+     *
+     * Each frame is passed by reference straight from the frame queue and removed
+     * after the callback returns. Frames received while the callback runs are
+     * consumed as well, up to `max` frames in total.
+     *
+     * @param callback Function called once per frame.
+     * @param ctx User pointer passed to the callback.
+     * @param max The maximum number of frames to consume.
+     * @return The number of frames consumed.
+     */
+    size_t consume(lorawan_frame_cb_t callback, void* ctx = nullptr, size_t max = SIZE_MAX);
+
     /**
      * @brief Reads and returns the available LoRaWAN frames from the buffer.
      *
@@ -1073,6 +1614,8 @@ public:
      *       process the frames to avoid re-reading the same data in subsequent
      *       calls. The function does not modify the internal buffer; it simply
      *       returns a copy of the frames.
+     * @note `peek()`/`pop()` and `consume()` give access to the frames without
+     *       copying them and remove only the frames that were handled.
      *
      * @return A vector of `lorawan_frame_t` containing all available frames
      *         in the internal buffer.
@@ -1096,7 +1639,7 @@ public:
      * @note After calling this function, any frames that were in the buffer
      *       will be lost, so ensure that frames are processed or saved
      *       before calling `flush()`.
-     * @note The serial flush only applies if the `_serial` object is properly
+     * @note The serial flush only applies if the transport is properly
      *       initialized and represents an active serial interface.
      */
     void flush();
@@ -1121,6 +1664,14 @@ public:
      */
     String getApplicationIdentifier();
 
+    /**
+     * @brief Reads the AppEUI without allocating, see `getApplicationIdentifier()`.
+     *
+     * @param appeui Receives the 8-byte AppEUI, most significant byte first.
+     * @return `true` if the module answered with a key of the expected length.
+     */
+    bool getApplicationIdentifier(uint8_t (&appeui)[8]);
+
     /**
      * @brief Retrieves the application key (AppKey).
      *
@@ -1141,6 +1692,14 @@ public:
      */
     String getApplicationKey();
 
+    /**
+     * @brief Reads the AppKey without allocating, see `getApplicationKey()`.
+     *
+     * @param appkey Receives the 16-byte AppKey.
+     * @return `true` if the module answered with a key of the expected length.
+     */
+    bool getApplicationKey(uint8_t (&appkey)[16]);
+
     /**
      * @brief Retrieves the application session key (AppSKey).
      *
@@ -1148,7 +1707,7 @@ public:
      * application session key (AppSKey). The AppSKey is a key used for
      * encrypting and decrypting the application payload in LoRaWAN communication.
      *
-     * The function constructs and sends the command `AT+APPSKEY?` to the
+     * The function constructs and sends the command `AT+APPSKEY=?` to the
      * module, and returns the response as a `String`. This allows users to
      * access the current application session key configured in the device.
      *
@@ -1161,6 +1720,14 @@ public:
      */
     String getApplicationSessionKey();
 
+    /**
+     * @brief Reads the AppSKey without allocating, see `getApplicationSessionKey()`.
+     *
+     * @param appskey Receives the 16-byte AppSKey.
+     * @return `true` if the module answered with a key of the expected length.
+     */
+    bool getApplicationSessionKey(uint8_t (&appskey)[16]);
+
     /**
      * @brief Retrieves the network session key (NwkSKey).
      *
@@ -1182,6 +1749,14 @@ public:
      */
     String getNetworkSessionKey();
 
+    /**
+     * @brief Reads the NwkSKey without allocating, see `getNetworkSessionKey()`.
+     *
+     * @param nwkskey Receives the 16-byte NwkSKey.
+     * @return `true` if the module answered with a key of the expected length.
+     */
+    bool getNetworkSessionKey(uint8_t (&nwkskey)[16]);
+
     /**
      * @brief Retrieves the network identifier (NetID).
      *
@@ -1224,6 +1799,14 @@ public:
      */
     String getDevAddr();
 
+    /**
+     * @brief Reads the DevAddr without allocating, see `getDevAddr()`.
+     *
+     * @param devaddr Receives the 4-byte DevAddr, most significant byte first.
+     * @return `true` if the module answered with a key of the expected length.
+     */
+    bool getDevAddr(uint8_t (&devaddr)[4]);
+
     /*
      * @brief Retrieves the global device identifier (DevEUI).
      *
@@ -1245,6 +1828,14 @@ public:
      */
     String getDevEUI();
 
+    /**
+     * @brief Reads the DevEUI without allocating, see `getDevEUI()`.
+     *
+     * @param deveui Receives the 8-byte DevEUI, most significant byte first.
+     * @return `true` if the module answered with a key of the expected length.
+     */
+    bool getDevEUI(uint8_t (&deveui)[8]);
+
     /**
      * @brief Retrieves the Adaptive Data Rate (ADR) status.
      *
@@ -1267,6 +1858,14 @@ public:
      */
     String getADR();
 
+    /**
+     * @brief Reads the ADR status without allocating, see `getADR()`.
+     *
+     * @param enable Receives `true` if ADR is enabled.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getADR(bool& enable);
+
     /**
      * @brief Retrieves the Duty Cycle Switch (DCS) status.
      *
@@ -1291,6 +1890,14 @@ public:
      */
     String getDCS();
 
+    /**
+     * @brief Reads the DCS status without allocating, see `getDCS()`.
+     *
+     * @param enable Receives `true` if the duty cycle limitation is enabled.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getDCS(bool& enable);
+
     /**
      * @brief Retrieves the duty cycle time.
      *
@@ -1326,7 +1933,7 @@ public:
      * network, impacting both the range and the power consumption of the
      * device.
      *
-     * The function constructs and sends the command `AT+DR?` to the
+     * The function constructs and sends the command `AT+DR=?` to the
      * module, and returns the response as a `String`. This allows users to
      * access the current data rate setting configured on the device.
      *
@@ -1346,6 +1953,14 @@ public:
      */
     String getDR();
 
+    /**
+     * @brief Reads the data rate without allocating, see `getDR()`.
+     *
+     * @param dr Receives the data rate.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getDR(uint8_t& dr);
+
     /**
      * @brief Retrieves the RX1 window join delay.
      *
@@ -1370,6 +1985,14 @@ public:
      */
     String getJoinRX1Delay();
 
+    /**
+     * @brief Reads the RX1 join delay without allocating, see `getJoinRX1Delay()`.
+     *
+     * @param delay Receives the delay in seconds.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getJoinRX1Delay(uint8_t& delay);
+
     /**
      * @brief Retrieves the RX2 window join delay.
      *
@@ -1395,6 +2018,14 @@ public:
      */
     String getJoinRX2Delay();
 
+    /**
+     * @brief Reads the RX2 join delay without allocating, see `getJoinRX2Delay()`.
+     *
+     * @param delay Receives the delay in seconds.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getJoinRX2Delay(uint8_t& delay);
+
     /**
      * @brief Retrieves the RX1 window delay.
      *
@@ -1419,6 +2050,14 @@ public:
      */
     String getRX1Delay();
 
+    /**
+     * @brief Reads the RX1 delay without allocating, see `getRX1Delay()`.
+     *
+     * @param delay Receives the delay in seconds.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getRX1Delay(uint8_t& delay);
+
     /**
      * @brief Retrieves the RX2 window delay.
      *
@@ -1444,6 +2083,14 @@ public:
      */
     String getRX2Delay();
 
+    /**
+     * @brief Reads the RX2 delay without allocating, see `getRX2Delay()`.
+     *
+     * @param delay Receives the delay in seconds.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getRX2Delay(uint8_t& delay);
+
     /**
      * @brief Retrieves the RX2 window data rate.
      *
@@ -1467,6 +2114,14 @@ public:
      */
     String getRX2DR();
 
+    /**
+     * @brief Reads the RX2 data rate without allocating, see `getRX2DR()`.
+     *
+     * @param dr Receives the RX2 data rate.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getRX2DR(uint8_t& dr);
+
     /**
      * @brief Retrieves the RX2 window frequency.
      *
@@ -1491,6 +2146,14 @@ public:
      */
     String getRX2Freq();
 
+    /**
+     * @brief Reads the RX2 frequency without allocating, see `getRX2Freq()`.
+     *
+     * @param freq Receives the frequency in Hz.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getRX2Freq(uint32_t& freq);
+
     /**
      * @brief Retrieves the transmission output power.
      *
@@ -1519,6 +2182,14 @@ public:
      */
     String getOutPower();
 
+    /**
+     * @brief Reads the TX power without allocating, see `getOutPower()`.
+     *
+     * @param power Receives the TX power index.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getOutPower(uint8_t& power);
+
     /**
      * @brief Retrieves the retransmission count for confirmed packets.
      *
@@ -1546,6 +2217,14 @@ public:
      */
     String getRetransmission();
 
+    /**
+     * @brief Reads the retransmission count without allocating, see `getRetransmission()`.
+     *
+     * @param count Receives the number of retransmissions.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getRetransmission(uint8_t& count);
+
     /**
      * @brief Retrieves the channel mask configuration.
      *
@@ -1609,6 +2288,14 @@ public:
      */
     String getBAND();
 
+    /**
+     * @brief Reads the band number without allocating, see `getBAND()`.
+     *
+     * @param band Receives the band number.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getBAND(uint8_t& band);
+
     /**
      * @brief Retrieves the link check configuration for the device.
      *
@@ -1637,6 +2324,14 @@ public:
      */
     String getLinkCheck();
 
+    /**
+     * @brief Reads the link check mode without allocating, see `getLinkCheck()`.
+     *
+     * @param mode Receives the link check mode.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getLinkCheck(lorawan_linkcheck_t& mode);
+
     /**
      * @brief Retrieves the multicast group configuration.
      *
@@ -1682,11 +2377,93 @@ public:
      */
     String getNetworkState();
 
+    /**
+     * @brief Reads the join state without allocating, see `getNetworkState()`.
+     *
+     * @param joined Receives `true` if the device has joined the network.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getNetworkState(bool& joined);
+
+    /**
+     * @brief Reads the whole LoRaWAN configuration and state of the module in one pass.
+     *
+     * The 25 queries behind the fields of `lorawan_snapshot_t` are pipelined with
+     * `getCommands()`, so the snapshot takes roughly the time the module needs to answer
+     * them instead of 25 separate round trips. Fields of queries answered with an error
+     * are left empty or zero and counted in `errors`, as are values too long for their field.
+     *
+     * @note Every value is copied into the caller's struct and the return value comes from
+     *       this batch only, so neither depends on `getLastResult()`, which the next command
+     *       overwrites.
+     *
+     * @param snapshot Receives the configuration.
+     * @return `true` if the module answered every query, `false` if a query timed out.
+     */
+    bool snapshot(lorawan_snapshot_t* snapshot);
+
+protected:
+    /**
+     * @brief Handles one unsolicited LoRaWAN event (see `update()`).
+     *
+     * @param event The decoded event line.
+     */
+    void handleEvent(const rak3172_event_t& event) override;
+
+    /**
+     * @brief Sends the next join request and the held uplinks when they are due.
+     */
+    void handleTimers() override;
+
 private:
     /**
-     * @brief A vector holding received LoRaWAN frames.
+     * @brief Records a failed join attempt and schedules the next one. Called with `_join_lock` held.
+     */
+    void joinFailed(uint32_t now);
+
+    /**
+     * @brief Returns the delay before the next join attempt, see `beginJoin()`.
      */
-    std::vector<lorawan_frame_t> _frames;
+    uint32_t joinBackoff(uint32_t now);
+
+    /**
+     * @brief Drops the held uplinks when the join stops. Called with `_join_lock` held.
+     */
+    void dropUplinks();
+
+    /**
+     * @brief Holds an uplink while a join is in progress.
+     *
+     * @param pending Set to `true` if the uplink must not be sent now.
+     * @return `size` if the uplink was held, 0 otherwise.
+     */
+    size_t holdUplink(const uint8_t* buf, size_t size, int port, bool* pending);
+
+    /**
+     * @brief Sends the held uplinks in order once the device has joined.
+     *
+     * An uplink rejected with `AT_BUSY_ERROR` is put back and retried from `handleTimers()`
+     * after `RAK3172_UPLINK_RETRY_MIN_MS`, doubling up to `RAK3172_UPLINK_RETRY_MAX_MS`.
+     */
+    void flushUplinks();
+
+    /**
+     * @brief Parses a `+EVT:RX_` line and queues the frame, see `parse()`.
+     *
+     * @return The queued frame, or nullptr if the line is invalid or the queue is full.
+     *         The frame stays valid until the next call.
+     */
+    lorawan_frame_t* parseFrame(const char* line, size_t len);
+
+    /**
+     * @brief Passes an error event to `_onError`.
+     */
+    void reportError(const rak3172_event_t& event);
+
+    /**
+     * @brief Fixed-capacity queue holding received LoRaWAN frames.
+     */
+    RAK3172FrameQueue<lorawan_frame_t, RAK3172_FRAME_QUEUE_SIZE> _frames;
 
     /**
      * @brief Current device class mode.
@@ -1696,12 +2473,32 @@ private:
     /**
      * @brief Current join mode (OTAA or ABP).
      */
-    lorawan_join_mode_t _join_mode;
+    lorawan_join_mode_t _join_mode = OTAA;
 
     /**
      * @brief Indicates if the device has successfully joined the network.
      */
-    bool _is_joined;
+    bool _is_joined = false;
+
+    /**
+     * @brief Join state machine, see `beginJoin()`, protected by `_join_lock`.
+     */
+    RAK3172Lock _join_lock;
+    lorawan_join_state_t _join_state = LORAWAN_JOIN_IDLE;
+    uint32_t _join_max_attempts      = 0;
+    uint32_t _join_start             = 0;
+    uint32_t _join_deadline          = 0;
+    lorawan_join_stats_t _join_stats = {};
+
+    /**
+     * @brief Uplinks held until the device has joined, protected by `_join_lock`.
+     */
+    lorawan_uplink_t _uplinks[RAK3172_UPLINK_QUEUE_SIZE];
+    uint8_t _uplink_head  = 0;
+    uint8_t _uplink_count     = 0;
+    uint8_t _uplink_retries   = 0;
+    uint32_t _uplink_deadline = 0;
+    bool _flushing            = false;
 
     /**
      * @brief Indicates if data confirmation is enabled.
@@ -1711,28 +2508,41 @@ private:
     /**
      * @brief Callback function invoked when a frame is received.
      *
-     * @param frame The received LoRaWAN frame.
+     * Callbacks registered with a plain function pointer are stored as a trampoline with
+     * the function pointer as context.
      */
-    void (*_onReceive)(lorawan_frame_t);
+    lorawan_frame_cb_t _onReceive = nullptr;
+    void* _onReceiveCtx           = nullptr;
 
     /**
      * @brief Callback function invoked when a frame is sent.
      */
-    void (*_onSend)();
+    lorawan_send_cb_t _onSend = nullptr;
+    void* _onSendCtx          = nullptr;
 
     /**
      * @brief Callback function invoked when the device joins the network.
-     *
-     * @param success Indicates whether the join was successful.
      */
-    void (*_onJoin)(bool);
+    lorawan_result_cb_t _onJoin = nullptr;
+    void* _onJoinCtx            = nullptr;
 
     /**
      * @brief Callback function invoked on error occurrence.
-     *
-     * @param errorMsg Pointer to the error message string.
      */
-    void (*_onError)(char*);
+    lorawan_error_cb_t _onError = nullptr;
+    void* _onErrorCtx           = nullptr;
+
+    /**
+     * @brief Callback function invoked with the outcome of a confirmed uplink.
+     */
+    lorawan_result_cb_t _onConfirm = nullptr;
+    void* _onConfirmCtx            = nullptr;
+
+    /**
+     * @brief Callback function invoked with a link check result.
+     */
+    lorawan_linkcheck_cb_t _onLinkCheck = nullptr;
+    void* _onLinkCheckCtx               = nullptr;
 };
 
 #endif
@@ -6,46 +6,147 @@
 
 #include "rak3172_p2p.hpp"
 
-void RAK3172P2P::parse(String frame)
+// Older firmware reports the LoRa bandwidth as an index (0: 125, 1: 250, 2: 500 kHz), newer firmware in kHz.
+static uint16_t bandwidthKHz(const char* value)
+{
+    unsigned long bw = strtoul(value, nullptr, 10);
+    if (value[0] == '\0') {
+        return 0;
+    }
+    return bw < 3 ? 125 << bw : bw;
+}
+
+p2p_frame_t* RAK3172P2P::parseFrame(const char* line, size_t len)
 {
-    p2p_frame_t res;
-    int index = frame.indexOf("+EVT:RXP2P:");
-    if (index != -1) {
-        String tmp     = frame.substring(index + 11);
-        int rssi       = tmp.substring(0, tmp.indexOf(":")).toInt();
-        tmp            = tmp.substring(tmp.indexOf(":") + 1);
-        int snr        = tmp.substring(0, tmp.indexOf(":")).toInt();
-        tmp            = tmp.substring(tmp.indexOf(":") + 1);
-        String payload = decodeMsg(tmp);
-        res.rssi       = rssi;
-        res.snr        = snr;
-        res.len        = payload.length();
-        payload.toCharArray(res.payload, payload.length() + 1);
-        _frames.push_back(res);
+    // +EVT:RXP2P:-38:13:12312312
+    const char* end = line + len;
+    const char* p;
+    long rssi, snr;
+    p2p_frame_t* res;
+
+    if (len < 11 || memcmp(line, "+EVT:RXP2P:", 11) != 0) {
+        return nullptr;
+    }
+    if ((p = parseInt(line + 11, end, &rssi)) == nullptr || p == end || *p != ':') {
+        return nullptr;
+    }
+    if ((p = parseInt(p + 1, end, &snr)) == nullptr) {
+        return nullptr;
+    }
+    if (p < end && *p == ':') {
+        p++;
+    }
+    // Validate the payload before reserving a slot, which may evict the oldest frame.
+    if (!isHex(p, end - p) || (size_t)(end - p) / 2 > sizeof(res->payload) - 1) {
+#if defined RAK3172_DEBUG
+        serialPrintln("INVALID RX PAYLOAD");
+#else
+#endif
+        return nullptr;
     }
+#if RAK3172_STATS
+    uint32_t dropped = _frames.dropped();
+    res              = _frames.reserve();
+    _stats.frames_dropped += _frames.dropped() - dropped;
+#else
+    res = _frames.reserve();
+#endif
+    if (res == nullptr) {
+        return nullptr;
+    }
+    res->len               = hex2bytes(p, end - p, (uint8_t*)res->payload, sizeof(res->payload) - 1);
+    res->payload[res->len] = '\0';
+    res->rssi              = rssi;
+    res->snr               = snr;
+    _frames.commit();
+#if RAK3172_STATS
+    _stats.frames_parsed++;
+#endif
+    return res;
+}
+
+void RAK3172P2P::parse(const char* line, size_t len)
+{
+    parseFrame(line, len);
+}
+
+void RAK3172P2P::parse(String frame)
+{
+    parse(frame.c_str(), frame.length());
 }
 
 void RAK3172P2P::update()
 {
-    if (xSemaphoreTake(_serial_mutex, portMAX_DELAY) == pdTRUE) {
-        String res = _serial->readStringUntil('\n');
-        xSemaphoreGive(_serial_mutex);
-        Serial.print(res);
-        if (res.indexOf("+EVT:RXP2P") != -1) {
-            if (res.indexOf("ERROR") != -1) {
-            } else {
-                res.remove(res.length() - 1);
-                parse(res);
+    processInput();
+}
+
+void RAK3172P2P::handleEvent(const rak3172_event_t& event)
+{
+    p2p_frame_t* frame;
+    switch (event.type) {
+        case RAK3172_EVENT_RXP2P:
+            frame = parseFrame(event.line, event.len);
+            if (frame != nullptr && _onReceive) {
+                _onReceive(*frame, _onReceiveCtx);
             }
-        }
-        if (res.indexOf("+EVT:TXP2P DONE") != -1) {
-        }
+            break;
+        case RAK3172_EVENT_TXP2P_DONE:
+            if (_onSend) {
+                _onSend(_onSendCtx);
+            }
+            break;
+        case RAK3172_EVENT_RXP2P_ERROR:
+            reportError(event);
+            break;
+        default:
+            break;
     }
 }
 
+bool RAK3172P2P::onReceive(p2p_frame_cb_t callback, void* ctx)
+{
+    _onReceive    = callback;
+    _onReceiveCtx = ctx;
+    return true;
+}
+
+bool RAK3172P2P::onSend(p2p_send_cb_t callback, void* ctx)
+{
+    _onSend    = callback;
+    _onSendCtx = ctx;
+    return true;
+}
+
+bool RAK3172P2P::onError(p2p_error_cb_t callback, void* ctx)
+{
+    _onError    = callback;
+    _onErrorCtx = ctx;
+    return true;
+}
+
+void RAK3172P2P::reportError(const rak3172_event_t& event)
+{
+    char msg[64];
+    if (_onError) {
+        // Strip the "+EVT:" prefix
+        snprintf(msg, sizeof(msg), "%.*s", (int)(event.len - 5), event.line + 5);
+        _onError(msg, _onErrorCtx);
+    }
+}
+
+#if defined RAK3172_USE_FREERTOS
 bool RAK3172P2P::init(HardwareSerial* serial, int rx, int tx, rak3172_bps_t baudRate)
 {
-    RAK3172::init(serial, rx, tx, baudRate);
+    _tx_pin = tx;
+    _rx_pin = rx;
+    _uart.begin(serial, bps2baud(baudRate), rx, tx);
+    return init(&_uart);
+}
+#endif
+
+bool RAK3172P2P::init(RAK3172Transport* transport)
+{
+    RAK3172::init(transport);
     restart();
     delay(100);
     return (sendCommand("AT") && sendCommand("AT+NWM=0"));
@@ -59,8 +160,7 @@ bool RAK3172P2P::restart()
 
 bool RAK3172P2P::config(long freq, int sf, int bw, int cr, int prlen, int pwr)
 {
-    return sendCommand("AT+P2P=" + String(freq) + ":" + String(sf) + ":" + String(bw) + ":" + String(cr) + ":" +
-                       String(prlen) + ":" + String(pwr));
+    return sendCommandf("AT+P2P=%ld:%d:%d:%d:%d:%d", freq, sf, bw, cr, prlen, pwr);
 }
 
 bool RAK3172P2P::setMode(p2p_mode_t mode, time_t timeout)
@@ -70,7 +170,7 @@ bool RAK3172P2P::setMode(p2p_mode_t mode, time_t timeout)
         status = sendCommand("AT+PRECV=0");
     }
     if (mode == P2P_RX_MODE) {
-        status = sendCommand("AT+PRECV=" + String(timeout));
+        status = sendCommandf("AT+PRECV=%ld", (long)timeout);
     }
 
     if (mode == P2P_TX_RX_MODE) {
@@ -85,88 +185,99 @@ bool RAK3172P2P::setMode(p2p_mode_t mode, time_t timeout)
 
 bool RAK3172P2P::setFreq(long freq)
 {
-    return sendCommand("AT+PFREQ=" + String(freq));
+    return sendCommandf("AT+PFREQ=%ld", freq);
 }
 
 bool RAK3172P2P::setSpreadingFactor(uint8_t sf)
 {
     sf = constrain(sf, 6, 12);
-    return sendCommand("AT+PSF=" + String(sf));
+    return sendCommandf("AT+PSF=%u", sf);
 }
 
 bool RAK3172P2P::setBandWidth(int bw)
 {
     bw = constrain(bw, 125, 500);
-    return sendCommand("AT+PBW=" + String(bw));
+    return sendCommandf("AT+PBW=%d", bw);
 }
 
 bool RAK3172P2P::setCodingRate(int8_t cr)
 {
     cr = constrain(cr, 0, 3);
-    return sendCommand("AT+PCR=" + String(cr));
+    return sendCommandf("AT+PCR=%d", cr);
 }
 
 bool RAK3172P2P::setOutPower(uint8_t power)
 {
-    return sendCommand("AT+PTP=" + String(power));
+    return sendCommandf("AT+PTP=%u", power);
 }
 
 bool RAK3172P2P::setPreambleLength(uint16_t preambleLength)
 {
-    return sendCommand("AT+PPL=" + String(preambleLength));
+    return sendCommandf("AT+PPL=%u", preambleLength);
 }
 
 bool RAK3172P2P::setSyncword(int sync)
 {
-    String syncStr = String(sync);
-    while (syncStr.length() < 4) {
-        syncStr = "0" + syncStr;  // Add leading zeros
-    }
-    return sendCommand("AT+SYNCWORD=" + syncStr);
+    return sendCommandf("AT+SYNCWORD=%04d", sync);  // Add leading zeros
 }
 
 bool RAK3172P2P::setEncipher(bool en)
 {
-    return sendCommand("AT+ENCRY=" + String(en));
+    return sendCommandf("AT+ENCRY=%d", en);
 }
 
-bool RAK3172P2P::setEncryptionKey(const String& key)
+bool RAK3172P2P::setEncryptionKey(const char* key)
 {
     if (!checkString(key, 16)) {
         return false;
     }
-    return sendCommand("AT+ENCKEY=" + String(key));
+    return sendCommandf("AT+ENCKEY=%s", key);
+}
+
+bool RAK3172P2P::setEncryptionKey(const String& key)
+{
+    return setEncryptionKey(key.c_str());
 }
 
 bool RAK3172P2P::setPasswordState(bool en)
 {
-    return sendCommand("AT+PCRYPT=" + String(en));
+    return sendCommandf("AT+PCRYPT=%d", en);
 }
 
-bool RAK3172P2P::setEncryptionDecryptionKey(const String& key)
+bool RAK3172P2P::setEncryptionDecryptionKey(const char* key)
 {
     if (!checkString(key, 8)) {
         return false;
     }
-    return sendCommand("AT+PKEY=" + String(key));
+    return sendCommandf("AT+PKEY=%s", key);
 }
 
-bool RAK3172P2P::setEncryptionIV(const String& key)
+bool RAK3172P2P::setEncryptionDecryptionKey(const String& key)
+{
+    return setEncryptionDecryptionKey(key.c_str());
+}
+
+bool RAK3172P2P::setEncryptionIV(const char* key)
 {
     if (!checkString(key, 16)) {
         return false;
     }
-    return sendCommand("AT+CRYPIV=" + String(key));
+    return sendCommandf("AT+CRYPIV=%s", key);
+}
+
+bool RAK3172P2P::setEncryptionIV(const String& key)
+{
+    return setEncryptionIV(key.c_str());
 }
 
 bool RAK3172P2P::setFSKrate(uint16_t rate)
 {
-    return sendCommand("AT+PBR=" + String(rate));
+    return sendCommandf("AT+PBR=%u", rate);
 }
 
 bool RAK3172P2P::setFSKFrequencyDeviation(uint16_t freq)
 {
-    return sendCommand("AT+PFDEV=" + String(freq));
+    return sendCommandf("AT+PFDEV=%u", freq);
 }
 
 String RAK3172P2P::getFreq()
@@ -174,39 +285,84 @@ String RAK3172P2P::getFreq()
     return getCommand("AT+PFREQ=?");
 }
 
+bool RAK3172P2P::getFreq(uint32_t& freq)
+{
+    uint32_t value;
+    if (!getNumber("AT+PFREQ=?", &value)) {
+        return false;
+    }
+    freq = value;
+    return true;
+}
+
 String RAK3172P2P::getSpreadingFactor()
 {
     return getCommand("AT+PSF=?");
 }
 
+bool RAK3172P2P::getSpreadingFactor(uint8_t& sf)
+{
+    uint32_t value;
+    if (!getNumber("AT+PSF=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    sf = value;
+    return true;
+}
+
 String RAK3172P2P::getBandwidth()
 {
-    String data = getCommand("AT+PBW=?");
-    if (strcmp(data.c_str(), "0")) {
-        return "125";
-    } else if (strcmp(data.c_str(), "1")) {
-        return "250";
-    } else if (strcmp(data.c_str(), "2")) {
-        return "500";
-    } else {
-        return "error";
+    switch (bandwidthKHz(getCommand("AT+PBW=?").c_str())) {
+        case 125:
+            return "125";
+        case 250:
+            return "250";
+        case 500:
+            return "500";
+        default:
+            return "error";
+    }
+}
+
+bool RAK3172P2P::getBandwidth(p2p_bw_t& bw)
+{
+    char value[8];
+    if (!getCommand("AT+PBW=?", value, sizeof(value))) {
+        return false;
+    }
+    switch (bandwidthKHz(value)) {
+        case 125:
+            bw = P2P_BW_125;
+            return true;
+        case 250:
+            bw = P2P_BW_250;
+            return true;
+        case 500:
+            bw = P2P_BW_500;
+            return true;
+        default:
+            return false;
     }
 }
 
 String RAK3172P2P::getCodingRate()
 {
-    String data = getCommand("AT+PCR=?");
-    if (strcmp(data.c_str(), "0")) {
-        return "4/5";
-    } else if (strcmp(data.c_str(), "1")) {
-        return "4/6";
-    } else if (strcmp(data.c_str(), "2")) {
-        return "4/7";
-    } else if (strcmp(data.c_str(), "3")) {
-        return "4/8";
-    } else {
+    p2p_cr_t cr;
+    if (!getCodingRate(cr)) {
         return "error";
     }
+    static const char* const names[] = {"4/5", "4/6", "4/7", "4/8"};
+    return names[cr];
+}
+
+bool RAK3172P2P::getCodingRate(p2p_cr_t& cr)
+{
+    uint32_t value;
+    if (!getNumber("AT+PCR=?", &value) || value > P2P_CR_4_8) {
+        return false;
+    }
+    cr = (p2p_cr_t)value;
+    return true;
 }
 
 String RAK3172P2P::getOutPower()
@@ -214,6 +370,16 @@ String RAK3172P2P::getOutPower()
     return getCommand("AT+PTP=?");
 }
 
+bool RAK3172P2P::getOutPower(uint8_t& power)
+{
+    uint32_t value;
+    if (!getNumber("AT+PTP=?", &value) || value > UINT8_MAX) {
+        return false;
+    }
+    power = value;
+    return true;
+}
+
 String RAK3172P2P::getSyncword()
 {
     return getCommand("AT+SYNCWORD=?");
@@ -224,6 +390,16 @@ String RAK3172P2P::getEncipher()
     return getCommand("AT+ENCRY=?");
 }
 
+bool RAK3172P2P::getEncipher(bool& enable)
+{
+    uint32_t value;
+    if (!getNumber("AT+ENCRY=?", &value) || value > 1) {
+        return false;
+    }
+    enable = value != 0;
+    return true;
+}
+
 String RAK3172P2P::getEncryptionKey()
 {
     return getCommand("AT+ENCKEY=?");
@@ -234,6 +410,16 @@ String RAK3172P2P::getPasswordState()
     return getCommand("AT+PCRYPT=?");
 }
 
+bool RAK3172P2P::getPasswordState(bool& enable)
+{
+    uint32_t value;
+    if (!getNumber("AT+PCRYPT=?", &value) || value > 1) {
+        return false;
+    }
+    enable = value != 0;
+    return true;
+}
+
 String RAK3172P2P::getEncryptionDecryptionKey()
 {
     return getCommand("AT+PKEY=?");
@@ -249,11 +435,41 @@ String RAK3172P2P::getFSKrate()
     return getCommand("AT+PBR=?");
 }
 
+bool RAK3172P2P::getFSKrate(uint32_t& rate)
+{
+    uint32_t value;
+    if (!getNumber("AT+PBR=?", &value)) {
+        return false;
+    }
+    rate = value;
+    return true;
+}
+
 String RAK3172P2P::getFSKFrequencyDeviation()
 {
     return getCommand("AT+PFDEV=?");
 }
 
+bool RAK3172P2P::getFSKFrequencyDeviation(uint32_t& freq)
+{
+    uint32_t value;
+    if (!getNumber("AT+PFDEV=?", &value)) {
+        return false;
+    }
+    freq = value;
+    return true;
+}
+
+void RAK3172P2P::setOverflowPolicy(rak3172_overflow_t policy)
+{
+    _frames.setPolicy(policy);
+}
+
+uint32_t RAK3172P2P::getDroppedFrames()
+{
+    return _frames.dropped();
+}
+
 int RAK3172P2P::available()
 {
     return _frames.size();
@@ -261,29 +477,123 @@ int RAK3172P2P::available()
 
 size_t RAK3172P2P::write(const uint8_t* buf, size_t size)
 {
-    String hexEncoded = bytes2hex(buf, size);
-    if (sendCommand("AT+PSEND=" + hexEncoded)) {
+    if (runCommand("AT+PSEND=", RAK3172_COMMAND_TIMEOUT, buf, size) == RAK3172_RESULT_OK) {
         return size;
     };
     return 0;
 }
 
+#if defined RAK3172_USE_FREERTOS
+static bool formatPSend(char* cmd, size_t cmd_size, const uint8_t* buf, size_t size)
+{
+    static const char prefix[] = "AT+PSEND=";
+    if (sizeof(prefix) - 1 + size * 2 >= cmd_size) {
+        return false;
+    }
+    memcpy(cmd, prefix, sizeof(prefix) - 1);
+    bytes2hex(buf, size, cmd + sizeof(prefix) - 1, cmd_size - sizeof(prefix) + 1);
+    return true;
+}
+
+bool RAK3172P2P::writeAsync(const uint8_t* buf, size_t size, rak3172_command_cb_t callback, void* ctx)
+{
+    char cmd[RAK3172_ASYNC_COMMAND_SIZE];
+    if (!formatPSend(cmd, sizeof(cmd), buf, size)) {
+        return false;
+    }
+    return sendCommandAsync(cmd, callback, ctx);
+}
+
+bool RAK3172P2P::writeAsync(const uint8_t* buf, size_t size, rak3172_future_t* future)
+{
+    char cmd[RAK3172_ASYNC_COMMAND_SIZE];
+    if (!formatPSend(cmd, sizeof(cmd), buf, size)) {
+        failFuture(future, RAK3172_RESULT_PARAM_OVERFLOW);
+        return false;
+    }
+    return sendCommandAsync(cmd, future);
+}
+#endif
+
 size_t RAK3172P2P::print(const char* str)
 {
-    String hexEncoded = encodeMsg(String(str));
-    if (sendCommand("AT+PSEND=" + hexEncoded)) {
-        return strlen(str);
-    };
-    return 0;
+    return write((const uint8_t*)str, strlen(str));
+}
+
+const p2p_frame_t* RAK3172P2P::peek()
+{
+    return _frames.front();
+}
+
+void RAK3172P2P::pop()
+{
+    _frames.pop();
+}
+
+size_t RAK3172P2P::consume(p2p_frame_cb_t callback, void* ctx, size_t max)
+{
+    const p2p_frame_t* frame;
+    size_t count = 0;
+    while (count < max && (frame = _frames.front()) != nullptr) {
+        callback(*frame, ctx);
+        _frames.pop();
+        count++;
+    }
+    return count;
 }
 
 std::vector<p2p_frame_t> RAK3172P2P::read()
 {
-    return _frames;
+    std::vector<p2p_frame_t> frames;
+    if (_frames.front() != nullptr) {
+        size_t count = _frames.size();
+        frames.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            frames.push_back(_frames.at(i));
+        }
+        _frames.release();
+    }
+    return frames;
 }
 
 void RAK3172P2P::flush()
 {
-    _serial->flush();
+    _transport->flush();
     _frames.clear();
 }
+
+bool RAK3172P2P::snapshot(p2p_snapshot_t* snapshot)
+{
+    // Parsed below in this order.
+    static const char* const queries[] = {
+        "AT+VER=?",    "AT+PFREQ=?",  "AT+PSF=?",    "AT+PBW=?",  "AT+PCR=?",    "AT+PPL=?", "AT+PTP=?",
+        "AT+SYNCWORD=?", "AT+ENCRY=?", "AT+ENCKEY=?", "AT+PCRYPT=?", "AT+PKEY=?", "AT+CRYPIV=?", "AT+PBR=?",
+        "AT+PFDEV=?",
+    };
+    const size_t count = sizeof(queries) / sizeof(queries[0]);
+    // Sized to the largest field, the keys and the IV.
+    char values[count][sizeof(snapshot->enckey)];
+    rak3172_result_t result;
+    size_t answered = getCommands(queries, count, values[0], sizeof(values[0]), RAK3172_COMMAND_TIMEOUT, &result);
+    size_t i        = 0;
+    uint8_t errors  = 0;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    errors += !copyString(snapshot->version, sizeof(snapshot->version), values[i++]);
+    snapshot->freq        = strtoul(values[i++], nullptr, 10);
+    snapshot->sf          = strtoul(values[i++], nullptr, 10);
+    snapshot->bandwidth   = bandwidthKHz(values[i++]);
+    snapshot->coding_rate = strtoul(values[i++], nullptr, 10);
+    snapshot->preamble    = strtoul(values[i++], nullptr, 10);
+    snapshot->tx_power    = strtoul(values[i++], nullptr, 10);
+    errors += !copyString(snapshot->syncword, sizeof(snapshot->syncword), values[i++]);
+    snapshot->encryption = values[i++][0] == '1';
+    errors += !copyString(snapshot->enckey, sizeof(snapshot->enckey), values[i++]);
+    snapshot->crypt = values[i++][0] == '1';
+    errors += !copyString(snapshot->pkey, sizeof(snapshot->pkey), values[i++]);
+    errors += !copyString(snapshot->iv, sizeof(snapshot->iv), values[i++]);
+    snapshot->fsk_rate      = strtoul(values[i++], nullptr, 10);
+    snapshot->fsk_deviation = strtoul(values[i++], nullptr, 10);
+    snapshot->errors        = count - answered + errors;
+    return result != RAK3172_RESULT_TIMEOUT;
+}
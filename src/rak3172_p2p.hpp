@@ -11,6 +11,7 @@
 #include "Stream.h"
 #include <vector>
 #include "rak3172_common.hpp"
+#include "rak3172_queue.hpp"
 
 /**
  * @brief Structure representing a point-to-point (P2P) frame.
@@ -26,6 +27,53 @@ typedef struct {
     char payload[500]; /**< Payload data (up to 500 bytes).*/
 } p2p_frame_t;
 
+/**
+ * @brief Callback type used by `RAK3172P2P::consume()`.
+ *
+ * @param frame The received frame. The reference is only valid during the call.
+ * @param ctx The user pointer passed to `consume()`.
+ */
+typedef void (*p2p_frame_cb_t)(const p2p_frame_t& frame, void* ctx);
+
+/**
+ * @brief Callback type used by `RAK3172P2P::onSend()`.
+ *
+ * @param ctx The user pointer passed to `onSend()`.
+ */
+typedef void (*p2p_send_cb_t)(void* ctx);
+
+/**
+ * @brief Callback type used by `RAK3172P2P::onError()`.
+ *
+ * @param error The event line without its `+EVT:` prefix, e.g. `RXP2P RECEIVE TIMEOUT`.
+ * @param ctx The user pointer passed to `onError()`.
+ */
+typedef void (*p2p_error_cb_t)(const char* error, void* ctx);
+
+/**
+ * @brief P2P radio configuration of the module, see `RAK3172P2P::snapshot()`.
+ *
+ * Keys are kept as the hexadecimal strings reported by the module.
+ */
+typedef struct {
+    char version[32];       /**< Firmware version (`AT+VER`) */
+    uint32_t freq;          /**< Frequency in Hz (`AT+PFREQ`) */
+    uint8_t sf;             /**< Spreading factor (`AT+PSF`) */
+    uint16_t bandwidth;     /**< Bandwidth in kHz (`AT+PBW`) */
+    uint8_t coding_rate;    /**< Coding rate, 0 to 3 for 4/5 to 4/8 (`AT+PCR`) */
+    uint16_t preamble;      /**< Preamble length (`AT+PPL`) */
+    uint8_t tx_power;       /**< TX power in dBm (`AT+PTP`) */
+    char syncword[8];       /**< Sync word (`AT+SYNCWORD`) */
+    bool encryption;        /**< Encryption enabled (`AT+ENCRY`) */
+    char enckey[33];        /**< Encryption key (`AT+ENCKEY`) */
+    bool crypt;             /**< Payload encryption enabled (`AT+PCRYPT`) */
+    char pkey[33];          /**< Encryption/decryption key (`AT+PKEY`) */
+    char iv[33];            /**< Encryption IV (`AT+CRYPIV`) */
+    uint32_t fsk_rate;      /**< FSK bit rate in bps (`AT+PBR`) */
+    uint32_t fsk_deviation; /**< FSK frequency deviation in Hz (`AT+PFDEV`) */
+    uint8_t errors;         /**< Queries answered with an error or too long for their field */
+} p2p_snapshot_t;
+
 /**
  * @brief Enumeration representing the modes of point-to-point (P2P) communication.
  *
@@ -40,8 +88,28 @@ typedef enum {
     P2P_TX_RX_MODE   /**< Both transmit and receive mode.*/
 } p2p_mode_t;
 
+/**
+ * @brief LoRa bandwidth in P2P mode, as used by `AT+PBW`.
+ */
+typedef enum {
+    P2P_BW_125 = 0, /**< 125 kHz */
+    P2P_BW_250,     /**< 250 kHz */
+    P2P_BW_500      /**< 500 kHz */
+} p2p_bw_t;
+
+/**
+ * @brief LoRa coding rate in P2P mode, as used by `AT+PCR`.
+ */
+typedef enum {
+    P2P_CR_4_5 = 0, /**< 4/5 */
+    P2P_CR_4_6,     /**< 4/6 */
+    P2P_CR_4_7,     /**< 4/7 */
+    P2P_CR_4_8      /**< 4/8 */
+} p2p_cr_t;
+
 class RAK3172P2P : public RAK3172 {
 public:
+#if defined RAK3172_USE_FREERTOS
     /**
      * @brief Initializes the RAK3172 P2P module.
      *
@@ -66,6 +134,19 @@ public:
      *         false if any command failed or the initialization was unsuccessful.
      */
     bool init(HardwareSerial* serial = &Serial2, int rx = 16, int tx = 17, rak3172_bps_t baudRate = RAK3172_BPS_115200);
+#endif
+
+    /**
+     * @brief Initializes the module on an already opened transport.
+     *
+     * Performs the same configuration as the `HardwareSerial` overload, e.g. over a
+     * `RAK3172PosixTransport` on a Linux host.
+     *
+     * @param transport The transport connected to the module.
+     * @return true if the initialization commands were successfully sent;
+     *         false otherwise.
+     */
+    bool init(RAK3172Transport* transport);
 
     /**
      * @brief Restarts the RAK3172 P2P module.
@@ -92,8 +173,8 @@ public:
      * @note
      * - The function looks for the "+EVT:RXP2P:" prefix to identify valid P2P frames.
      * - It extracts the RSSI and SNR values from the frame, as well as the payload.
-     * - The payload is decoded using the `decodeMsg` function before being stored.
-     * - The resulting `p2p_frame_t` structure is pushed into the `_frames` vector.
+     * - The payload is decoded in place with `hex2bytes` before being stored.
+     * - The resulting `p2p_frame_t` structure is written into the `_frames` queue.
      *
      * @param frame The string representation of the received P2P frame to be parsed.
      *
@@ -101,20 +182,35 @@ public:
      */
     void parse(String frame);
 
+    /**
+     * @brief Parses a received "+EVT:RXP2P:" line in a single pass.
+     *
+     * The fields are read in place from `line` and the hex payload is decoded straight
+     * into the `payload` array of the new frame, so no intermediate strings are created.
+     * Every field is scanned within `len`, so `line` does not need to be null-terminated.
+     * Lines that are malformed or whose payload is not valid hex are discarded before a
+     * queue slot is reserved, so they never evict a queued frame.
+     *
+     * @param line Pointer to the received line.
+     * @param len The length of the line in characters.
+     */
+    void parse(const char* line, size_t len);
+
     /**
      * @brief Updates the state of the RAK3172 P2P module by reading incoming data.
      *
      * This function checks for incoming data from the RAK3172 P2P module.
-     * It uses a mutex to ensure thread-safe access to the serial interface.
-     * The function reads a line of data and processes it based on specific event indicators.
+     * It drains the bytes already received on the serial interface without waiting
+     * for more, and processes every complete event line, including the events that
+     * arrived while a command was waiting for its response.
      *
      * @note
-     * - The function waits indefinitely for access to the serial interface using a semaphore.
-     * - It reads data until a newline character is encountered.
-     * - If the received data contains the "+EVT:RXP2P" event, it checks for errors and
-     *   processes the data if no errors are found.
-     * - If the received data indicates that the transmission is complete with
-     *   "+EVT:TXP2P DONE", it can be handled accordingly (currently no action is taken).
+     * - The serial interface is read by a single demultiplexer shared with `sendCommand()`,
+     *   so received frames are never swallowed by a concurrent command.
+     * - A "+EVT:RXP2P" frame is parsed, queued and passed to `onReceive()`.
+     * - "+EVT:TXP2P DONE" calls `onSend()`.
+     * - "+EVT:RXP2P RECEIVE ERROR" and "+EVT:RXP2P RECEIVE TIMEOUT" call `onError()`.
+     * - All events, including reception errors, are then passed to the `onEvent()` callback.
      *
      * @return void This function does not return a value.
      */
@@ -348,6 +444,14 @@ public:
      * @return true if the encryption key configuration command was successfully sent;
      *         false if the command failed or if the key is invalid.
      */
+    bool setEncryptionKey(const char* key);
+
+    /**
+     * @brief Sets the key from a `String`, see `setEncryptionKey(const char*)`.
+     *
+     * @param key The 16-character hexadecimal key.
+     * @return true if the command was successfully sent; false otherwise.
+     */
     bool setEncryptionKey(const String& key);
 
     /**
@@ -385,6 +489,14 @@ public:
      * @return true if the key configuration command was successfully sent;
      *         false if the command failed or if the key is invalid.
      */
+    bool setEncryptionDecryptionKey(const char* key);
+
+    /**
+     * @brief Sets the key from a `String`, see `setEncryptionDecryptionKey(const char*)`.
+     *
+     * @param key The 8-character hexadecimal key.
+     * @return true if the command was successfully sent; false otherwise.
+     */
     bool setEncryptionDecryptionKey(const String& key);
 
     /**
@@ -406,6 +518,14 @@ public:
      * @return true if the IV configuration command was successfully sent;
      *         false if the command failed or if the IV is invalid.
      */
+    bool setEncryptionIV(const char* key);
+
+    /**
+     * @brief Sets the key from a `String`, see `setEncryptionIV(const char*)`.
+     *
+     * @param key The 16-character hexadecimal key.
+     * @return true if the command was successfully sent; false otherwise.
+     */
     bool setEncryptionIV(const String& key);
 
     /**
@@ -479,6 +599,8 @@ public:
      * - The hex-encoded string must consist of characters 0-9, a-f, A-F, and must
      *   have an even length.
      * - The command "AT+PSEND=<hexEncodedMessage>" is used to send the message.
+     * - The buffer is hex-encoded in small chunks while it is written to the serial
+     *   interface, so no copy of the encoded command is kept in RAM.
      *
      * @param buf A pointer to the byte buffer to be sent in P2P mode.
      * @param size The size of the byte buffer (must be between 2 and 500).
@@ -488,6 +610,52 @@ public:
      */
     size_t write(const uint8_t* buf, size_t size);
 
+#if defined RAK3172_USE_FREERTOS
+    /**
+     * @brief Queues a P2P transmission of a byte buffer and returns without waiting for the module.
+     *
+     * The `AT+PSEND` command is built immediately and executed by the worker task
+     * started with `beginAsync()`, which then calls `callback` with its final result.
+     *
+     * @param buf A pointer to the byte buffer to be sent in P2P mode.
+     * @param size The size of the byte buffer.
+     * @param callback Completion callback, or `nullptr` to fire and forget.
+     * @param ctx User context pointer passed to `callback`.
+     * @return `true` if the transmission was queued, `false` otherwise.
+     */
+    bool writeAsync(const uint8_t* buf, size_t size, rak3172_command_cb_t callback = nullptr, void* ctx = nullptr);
+
+    /**
+     * @brief Queues a P2P transmission of a byte buffer and reports its completion through a future.
+     *
+     * @param buf A pointer to the byte buffer to be sent in P2P mode.
+     * @param size The size of the byte buffer.
+     * @param future Caller-owned completion state, see `sendCommandAsync()`.
+     * @return `true` if the transmission was queued, `false` otherwise.
+     */
+    bool writeAsync(const uint8_t* buf, size_t size, rak3172_future_t* future);
+#endif
+
+    /**
+     * @brief Selects what happens to a received frame when the frame queue is full.
+     *
+     * The queue holds `RAK3172_FRAME_QUEUE_SIZE` frames. By default the oldest frame
+     * is discarded to make room for the new one.
+     *
+     * @note `RAK3172_OVERFLOW_BLOCK` stalls `update()` until a frame is consumed, so
+     *       it must only be used when the frames are read from a different task.
+     *
+     * @param policy The overflow policy.
+     */
+    void setOverflowPolicy(rak3172_overflow_t policy);
+
+    /**
+     * @brief Returns the number of received frames discarded because the queue was full.
+     *
+     * @return The number of dropped frames since the object was created.
+     */
+    uint32_t getDroppedFrames();
+
     /**
      * @brief Returns the number of available frames in the P2P buffer.
      *
@@ -503,6 +671,75 @@ public:
      */
     int available();
 
+    /**
+     * @brief Returns the oldest received P2P frame without removing it.
+     *
+     * The frame is not copied; the pointer refers to the slot inside the frame queue
+     * and stays valid until `pop()` or `flush()` is called. Frames that arrive in the
+     * meantime are appended behind it.
+     *
+     * @note The frame queue is a lock-free single-producer/single-consumer ring, so
+     *       `update()` may run in its own task while one other task reads frames.
+     *       A peeked frame is never overwritten: if the queue overflows before
+     *       `pop()`, the newly received frame is dropped instead.
+     *
+     * @return Pointer to the oldest frame, or nullptr if no frame is available.
+     */
+    const p2p_frame_t* peek();
+
+    /**
+     * @brief Removes the oldest received frame (the one returned by `peek()`).
+     */
+    void pop();
+
+    /**
+     * @brief Hands queued frames to a callback and removes exactly those frames.
+     *
+     * Each frame is passed by reference straight from the frame queue and removed
+     * after the callback returns. Frames received while the callback runs are
+     * consumed as well, up to `max` frames in total.
+     *
+     * @param callback Function called once per frame.
+     * @param ctx User pointer passed to the callback.
+     * @param max The maximum number of frames to consume.
+     * @return The number of frames consumed.
+     */
+    size_t consume(p2p_frame_cb_t callback, void* ctx = nullptr, size_t max = SIZE_MAX);
+
+    /**
+     * @brief Registers a callback receiving each received frame.
+     *
+     * The callback is called from `update()` (or the receive task, see `beginReceive()`)
+     * once the frame has been parsed and queued; the frame also stays in the queue.
+     *
+     * @param callback The callback, or `nullptr` to remove it. The frame reference is only
+     *        valid during the call.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onReceive(p2p_frame_cb_t callback, void* ctx = nullptr);
+
+    /**
+     * @brief Registers a callback called when a packet has been sent (`+EVT:TXP2P DONE`).
+     *
+     * @param callback The callback, or `nullptr` to remove it.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onSend(p2p_send_cb_t callback, void* ctx = nullptr);
+
+    /**
+     * @brief Registers a callback called when a reception fails or times out.
+     *
+     * The callback receives the event line without its `+EVT:` prefix, e.g.
+     * `RXP2P RECEIVE ERROR` or `RXP2P RECEIVE TIMEOUT`, like `RAK3172LoRaWAN::onError()`.
+     *
+     * @param callback The callback, or `nullptr` to remove it.
+     * @param ctx User pointer passed to the callback.
+     * @return Always `true`.
+     */
+    bool onError(p2p_error_cb_t callback, void* ctx = nullptr);
+
     /**
      * @brief Reads and returns the available frames from the P2P buffer.
      *
@@ -513,6 +750,8 @@ public:
      * @note
      * - The returned vector contains all frames stored in the `_frames` container.
      * - The user should ensure to process the frames appropriately after reading.
+     * - `peek()`/`pop()` and `consume()` give access to the frames without copying
+     *   them and remove only the frames that were handled.
      *
      * @return A vector containing the available frames from the P2P buffer.
      */
@@ -553,6 +792,14 @@ public:
      */
     String getFreq();
 
+    /**
+     * @brief Reads the frequency without allocating, see `getFreq()`.
+     *
+     * @param freq Receives the frequency in Hz.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getFreq(uint32_t& freq);
+
     /**
      * @brief Retrieves the current spreading factor setting for the P2P mode.
      *
@@ -570,6 +817,14 @@ public:
      */
     String getSpreadingFactor();
 
+    /**
+     * @brief Reads the spreading factor without allocating, see `getSpreadingFactor()`.
+     *
+     * @param sf Receives the spreading factor.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getSpreadingFactor(uint8_t& sf);
+
     /**
      * @brief Retrieves the current bandwidth setting for the P2P mode.
      *
@@ -596,6 +851,14 @@ public:
      */
     String getBandwidth();
 
+    /**
+     * @brief Reads the bandwidth without allocating, see `getBandwidth()`.
+     *
+     * @param bw Receives the bandwidth.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getBandwidth(p2p_bw_t& bw);
+
     /**
      * @brief Retrieves the current coding rate setting for the P2P mode.
      *
@@ -624,6 +887,14 @@ public:
      */
     String getCodingRate();
 
+    /**
+     * @brief Reads the coding rate without allocating, see `getCodingRate()`.
+     *
+     * @param cr Receives the coding rate.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getCodingRate(p2p_cr_t& cr);
+
     /**
      * @brief Retrieves the current transmission power setting for the P2P mode.
      *
@@ -642,6 +913,14 @@ public:
      */
     String getOutPower();
 
+    /**
+     * @brief Reads the TX power without allocating, see `getOutPower()`.
+     *
+     * @param power Receives the TX power in dBm.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getOutPower(uint8_t& power);
+
     /**
      * @brief Retrieves the current syncword setting for the P2P mode.
      *
@@ -678,6 +957,14 @@ public:
      */
     String getEncipher();
 
+    /**
+     * @brief Reads the encryption status without allocating, see `getEncipher()`.
+     *
+     * @param enable Receives `true` if encryption is enabled.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getEncipher(bool& enable);
+
     /**
      * @brief Retrieves the current encryption key for the P2P mode.
      *
@@ -714,6 +1001,14 @@ public:
      */
     String getPasswordState();
 
+    /**
+     * @brief Reads the payload encryption status without allocating, see `getPasswordState()`.
+     *
+     * @param enable Receives `true` if payload encryption is enabled.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getPasswordState(bool& enable);
+
     /**
      * @brief Retrieves the current encryption and decryption key for the P2P mode.
      *
@@ -771,6 +1066,14 @@ public:
      */
     String getFSKrate();
 
+    /**
+     * @brief Reads the FSK bit rate without allocating, see `getFSKrate()`.
+     *
+     * @param rate Receives the bit rate in bps.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getFSKrate(uint32_t& rate);
+
     /**
      * @brief Retrieves the current FSK (Frequency Shift Keying) frequency deviation for the P2P mode.
      *
@@ -790,14 +1093,47 @@ public:
      */
     String getFSKFrequencyDeviation();
 
+    /**
+     * @brief Reads the FSK frequency deviation without allocating, see `getFSKFrequencyDeviation()`.
+     *
+     * @param freq Receives the deviation in Hz.
+     * @return `true` if the module answered with a valid value.
+     */
+    bool getFSKFrequencyDeviation(uint32_t& freq);
+
+    /**
+     * @brief Reads the whole P2P radio configuration of the module in one pass.
+     *
+     * The queries behind the fields of `p2p_snapshot_t` are pipelined with `getCommands()`
+     * instead of being sent one round trip at a time. Fields of queries answered with an
+     * error are left empty or zero and counted in `errors`, as are values too long for
+     * their field.
+     *
+     * @note Every value is copied into the caller's struct and the return value comes from
+     *       this batch only, so neither depends on `getLastResult()`, which the next command
+     *       overwrites.
+     *
+     * @param snapshot Receives the configuration.
+     * @return `true` if the module answered every query, `false` if a query timed out.
+     */
+    bool snapshot(p2p_snapshot_t* snapshot);
+
+protected:
+    /**
+     * @brief Handles one unsolicited P2P event (see `update()`).
+     *
+     * @param event The decoded event line.
+     */
+    void handleEvent(const rak3172_event_t& event) override;
+
 private:
     /**
-     * @brief A vector to hold multiple P2P frames.
+     * @brief Fixed-capacity queue holding received P2P frames.
      *
-     * This variable stores a collection of P2P frames, allowing for the
-     * management and processing of multiple frames in point-to-point communication.
+     * Frames are written in place by `parse()` and stay in the queue until
+     * `flush()`; no heap memory is used for received frames.
      */
-    std::vector<p2p_frame_t> _frames;
+    RAK3172FrameQueue<p2p_frame_t, RAK3172_FRAME_QUEUE_SIZE> _frames;
 
     /**
      * @brief Current mode of point-to-point (P2P) communication.
@@ -806,6 +1142,37 @@ private:
      * which can be set to transmit, receive, or both modes.
      */
     p2p_mode_t _mode;
+
+    /**
+     * @brief Callback invoked with each received frame, see `onReceive()`.
+     */
+    p2p_frame_cb_t _onReceive = nullptr;
+    void* _onReceiveCtx       = nullptr;
+
+    /**
+     * @brief Callback invoked when a packet has been sent, see `onSend()`.
+     */
+    p2p_send_cb_t _onSend = nullptr;
+    void* _onSendCtx      = nullptr;
+
+    /**
+     * @brief Callback invoked when a reception fails, see `onError()`.
+     */
+    p2p_error_cb_t _onError = nullptr;
+    void* _onErrorCtx       = nullptr;
+
+    /**
+     * @brief Parses a `+EVT:RXP2P:` line and queues the frame, see `parse()`.
+     *
+     * @return The queued frame, or nullptr if the line is invalid or the queue is full.
+     *         The frame stays valid until the next call.
+     */
+    p2p_frame_t* parseFrame(const char* line, size_t len);
+
+    /**
+     * @brief Passes an error event to `_onError`.
+     */
+    void reportError(const rak3172_event_t& event);
 };
 
 #endif
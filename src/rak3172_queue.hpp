@@ -0,0 +1,240 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#ifndef _RAK3172_QUEUE_HPP_
+#define _RAK3172_QUEUE_HPP_
+
+#include <Arduino.h>
+#include <atomic>
+
+/**
+ * @def RAK3172_FRAME_QUEUE_SIZE
+ * @brief Number of received frames buffered by `RAK3172LoRaWAN` and `RAK3172P2P`.
+ *
+ * The frames are stored inside the driver object, so each additional slot costs the
+ * size of one frame (a little over 500 bytes) of static RAM. Must be a power of two.
+ */
+#ifndef RAK3172_FRAME_QUEUE_SIZE
+#define RAK3172_FRAME_QUEUE_SIZE 8
+#endif
+
+/**
+ * @brief What to do with a received frame when the frame queue is full.
+ */
+typedef enum {
+    RAK3172_OVERFLOW_DROP_OLDEST = 0, /**< Discard the oldest queued frame to make room */
+    RAK3172_OVERFLOW_DROP_NEWEST,     /**< Discard the frame that just arrived */
+    RAK3172_OVERFLOW_BLOCK            /**< Wait until the application has consumed a frame */
+} rak3172_overflow_t;
+
+/**
+ * @brief Fixed-capacity, lock-free ring of received frames.
+ *
+ * All slots are part of the object, so enqueue and dequeue are O(1) and never touch
+ * the heap. The ring is meant for exactly one producer (the task calling `update()`)
+ * and one consumer (the application task), which may run on different cores:
+ * - The producer writes a frame in place with `reserve()` followed by `commit()`.
+ * - The consumer reads the oldest frame with `front()` and releases it with `pop()`.
+ *
+ * The indices are C++11 atomics; a frame is published with a release store of the
+ * head index and handed back with a release update of the tail index. While the
+ * consumer holds a frame returned by `front()` the tail is pinned, so the
+ * drop-oldest policy never overwrites a frame that is being read: the new frame is
+ * dropped instead.
+ *
+ * @tparam T The frame type.
+ * @tparam N The number of slots, a power of two.
+ */
+template <typename T, size_t N>
+class RAK3172FrameQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "frame queue size must be a power of two");
+
+public:
+    RAK3172FrameQueue() : _head(0), _tail(0), _dropped(0), _policy(RAK3172_OVERFLOW_DROP_OLDEST)
+    {
+    }
+
+    /**
+     * @brief Returns a free slot for the next frame (producer side).
+     *
+     * When the queue is full the overflow policy decides what happens: the oldest frame
+     * is discarded right away, the new frame is refused, or the call waits until a slot
+     * is freed.
+     *
+     * @note The slot only becomes visible to the consumer after `commit()`. A slot that
+     *       is not committed is simply reused by the next call.
+     * @note With `RAK3172_OVERFLOW_BLOCK` the frames must be consumed from another task,
+     *       otherwise this call never returns.
+     *
+     * @return Pointer to the slot, or nullptr if the new frame has to be dropped.
+     */
+    T* reserve()
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        while (((head - tail) & INDEX_MASK) >= N) {
+            switch (_policy) {
+                case RAK3172_OVERFLOW_BLOCK:
+                    delay(1);
+                    tail = _tail.load(std::memory_order_acquire);
+                    continue;
+                case RAK3172_OVERFLOW_DROP_OLDEST:
+                    // While the consumer reads the oldest frame, the new one is dropped instead.
+                    if ((tail & PINNED) != 0) {
+                        _dropped.fetch_add(1, std::memory_order_relaxed);
+                        return nullptr;
+                    }
+                    if (_tail.compare_exchange_weak(tail, (tail + 1) & INDEX_MASK, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire)) {
+                        _dropped.fetch_add(1, std::memory_order_relaxed);
+                        return &_slots[head % N];
+                    }
+                    continue;
+                default:
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+            }
+        }
+        return &_slots[head % N];
+    }
+
+    /**
+     * @brief Publishes the slot returned by the last `reserve()` call (producer side).
+     */
+    void commit()
+    {
+        _head.store((_head.load(std::memory_order_relaxed) + 1) & INDEX_MASK, std::memory_order_release);
+    }
+
+    /**
+     * @brief Returns the oldest queued frame without removing it (consumer side).
+     *
+     * The frame stays valid, and is never overwritten, until `pop()`, `release()` or
+     * `clear()` is called.
+     *
+     * @return Pointer to the frame, or nullptr if the queue is empty.
+     */
+    T* front()
+    {
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        for (;;) {
+            if ((tail & INDEX_MASK) == _head.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            if ((tail & PINNED) != 0 || _tail.compare_exchange_weak(tail, tail | PINNED, std::memory_order_acq_rel,
+                                                                     std::memory_order_acquire)) {
+                return &_slots[(tail & INDEX_MASK) % N];
+            }
+        }
+    }
+
+    /**
+     * @brief Returns the i-th oldest queued frame (consumer side).
+     *
+     * @note Only valid between `front()` and `pop()`/`release()`, which keep the
+     *       producer from overwriting queued frames.
+     *
+     * @param i Index of the frame, must be less than `size()`.
+     * @return Reference to the frame.
+     */
+    T& at(size_t i)
+    {
+        return _slots[((_tail.load(std::memory_order_relaxed) & INDEX_MASK) + i) % N];
+    }
+
+    /**
+     * @brief Removes the oldest queued frame, if any (consumer side).
+     */
+    void pop()
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        do {
+            if ((tail & INDEX_MASK) == _head.load(std::memory_order_acquire)) {
+                return;
+            }
+        } while (!_tail.compare_exchange_weak(tail, ((tail & INDEX_MASK) + 1) & INDEX_MASK,
+                                              std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief Releases the frame returned by `front()` without removing it (consumer side).
+     */
+    void release()
+    {
+        _tail.fetch_and(INDEX_MASK, std::memory_order_release);
+    }
+
+    /**
+     * @brief Removes all queued frames (consumer side).
+     */
+    void clear()
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        while (!_tail.compare_exchange_weak(tail, _head.load(std::memory_order_acquire), std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Returns the number of queued frames.
+     */
+    size_t size() const
+    {
+        return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & INDEX_MASK;
+    }
+
+    /**
+     * @brief Returns true if no frame is queued.
+     */
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Returns the number of slots.
+     */
+    size_t capacity() const
+    {
+        return N;
+    }
+
+    /**
+     * @brief Returns the number of frames discarded because the queue was full.
+     */
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sets the overflow policy (`RAK3172_OVERFLOW_DROP_OLDEST` by default).
+     */
+    void setPolicy(rak3172_overflow_t policy)
+    {
+        _policy = policy;
+    }
+
+    /**
+     * @brief Returns the overflow policy.
+     */
+    rak3172_overflow_t getPolicy() const
+    {
+        return _policy;
+    }
+
+private:
+    static const uint32_t PINNED     = 0x80000000; /**< Set in `_tail` while the consumer holds the oldest frame */
+    static const uint32_t INDEX_MASK = 0x7fffffff; /**< Indices run modulo 2^31, a multiple of N */
+
+    T _slots[N];
+    std::atomic<uint32_t> _head;    /**< Next slot to publish, written by the producer */
+    std::atomic<uint32_t> _tail;    /**< Oldest queued slot plus the PINNED flag */
+    std::atomic<uint32_t> _dropped; /**< Number of frames discarded on overflow */
+    volatile rak3172_overflow_t _policy;
+};
+
+#endif
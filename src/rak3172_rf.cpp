@@ -18,23 +18,22 @@ bool RAK3172RF::startRadioFrequency()
 
 bool RAK3172RF::startSend(uint16_t num)
 {
-    return (sendCommand("AT+TTX=" + String(num)));
+    return (sendCommandf("AT+TTX=%u", num));
 }
 
 bool RAK3172RF::startRecv(uint16_t num)
 {
-    return (sendCommand("AT+TRX=" + String(num)));
+    return (sendCommandf("AT+TRX=%u", num));
 }
 
 bool RAK3172RF::setConfig(long freq, int pwr, int bw, int sf, int cr, int mode, int prlen, uint16_t fsk)
 {
-    return (sendCommand("AT+TCONF=" + String(freq) + ":" + String(pwr) + ":" + String(bw) + ":" + String(sf) + ":" +
-                        String(cr) + ":0:0:" + String(mode) + ":" + String(prlen) + ":" + String(fsk) + ":0:0"));
+    return (sendCommandf("AT+TCONF=%ld:%d:%d:%d:%d:0:0:%d:%d:%u:0:0", freq, pwr, bw, sf, cr, mode, prlen, fsk));
 }
 
 bool RAK3172RF::setSendFrequencyHopping(uint32_t Fstart, uint32_t Fstop, uint16_t Fdelta, int len)
 {
-    return (sendCommand("AT+TTH=" + String(Fstart) + ":" + String(Fstop) + ":" + String(Fdelta) + ":" + String(len)));
+    return (sendCommandf("AT+TTH=%lu:%lu:%u:%d", (unsigned long)Fstart, (unsigned long)Fstop, Fdelta, len));
 }
 
 bool RAK3172RF::stop()
@@ -49,10 +48,10 @@ bool RAK3172RF::loraCertification()
 
 bool RAK3172RF::RFcontinuity(long freq, int pwr, int time)
 {
-    return (sendCommand("AT+CW=" + String(freq) + ":" + String(pwr) + ":" + String(time)));
+    return (sendCommandf("AT+CW=%ld:%d:%d", freq, pwr, time));
 }
 
 bool RAK3172RF::setRandomFrequencyHopping(uint32_t Fstart, uint32_t Fstop, uint16_t Fdelta, int len)
 {
-    return (sendCommand("AT+TRTH=" + String(Fstart) + ":" + String(Fstop) + ":" + String(Fdelta) + ":" + String(len)));
+    return (sendCommandf("AT+TRTH=%lu:%lu:%u:%d", (unsigned long)Fstart, (unsigned long)Fstop, Fdelta, len));
 }
\ No newline at end of file
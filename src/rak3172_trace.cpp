@@ -0,0 +1,334 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#include "rak3172_trace.hpp"
+
+#define TRACE_RX      0x8000
+#define TRACE_MAX_LEN 0x7fff
+
+RAK3172TraceRecorder::RAK3172TraceRecorder(RAK3172Transport* transport)
+    : _transport(transport),
+      _head(0),
+      _used(0),
+      _open(0),
+      _open_rx(false),
+      _has_open(false),
+      _last_time(0),
+      _overruns(0),
+      _enabled(true)
+{
+}
+
+void RAK3172TraceRecorder::enable(bool enable)
+{
+    _enabled = enable;
+}
+
+uint8_t RAK3172TraceRecorder::at(size_t offset)
+{
+    return _buf[offset % RAK3172_TRACE_SIZE];
+}
+
+void RAK3172TraceRecorder::put(size_t offset, uint8_t value)
+{
+    _buf[offset % RAK3172_TRACE_SIZE] = value;
+}
+
+void RAK3172TraceRecorder::evict()
+{
+    size_t tail = (_head + RAK3172_TRACE_SIZE - _used) % RAK3172_TRACE_SIZE;
+    size_t len  = (at(tail + 4) | (at(tail + 5) << 8)) & TRACE_MAX_LEN;
+    if (_has_open && _open == tail) {
+        _has_open = false;
+    }
+    _used -= RAK3172_TRACE_HEADER_SIZE + len;
+    _overruns++;
+}
+
+void RAK3172TraceRecorder::record(bool rx, const uint8_t* data, size_t len)
+{
+    if (!_enabled || len == 0 || _lock.take() == false) {
+        return;
+    }
+    uint32_t now = micros();
+    while (len > 0) {
+        size_t open_len = 0;
+        if (_has_open) {
+            open_len = (at(_open + 4) | (at(_open + 5) << 8)) & TRACE_MAX_LEN;
+        }
+        if (!_has_open || _open_rx != rx || (uint32_t)(now - _last_time) >= RAK3172_TRACE_GAP_US ||
+            open_len == TRACE_MAX_LEN) {
+            while (RAK3172_TRACE_SIZE - _used < RAK3172_TRACE_HEADER_SIZE + 1) {
+                evict();
+            }
+            _open     = _head;
+            _open_rx  = rx;
+            _has_open = true;
+            open_len  = 0;
+            for (int i = 0; i < 4; i++) {
+                put(_head + i, now >> (8 * i));
+            }
+            put(_head + 4, 0);
+            put(_head + 5, rx ? TRACE_RX >> 8 : 0);
+            _head = (_head + RAK3172_TRACE_HEADER_SIZE) % RAK3172_TRACE_SIZE;
+            _used += RAK3172_TRACE_HEADER_SIZE;
+        }
+        if (_used == RAK3172_TRACE_SIZE) {
+            evict();
+            if (!_has_open) {
+                // The open record itself was the oldest one, start a new record.
+                continue;
+            }
+        }
+        size_t n = len;
+        if (n > RAK3172_TRACE_SIZE - _used) {
+            n = RAK3172_TRACE_SIZE - _used;
+        }
+        if (n > TRACE_MAX_LEN - open_len) {
+            n = TRACE_MAX_LEN - open_len;
+        }
+        for (size_t i = 0; i < n; i++) {
+            put(_head + i, data[i]);
+        }
+        _head = (_head + n) % RAK3172_TRACE_SIZE;
+        _used += n;
+        open_len += n;
+        put(_open + 4, open_len);
+        put(_open + 5, (open_len >> 8) | (rx ? TRACE_RX >> 8 : 0));
+        data += n;
+        len -= n;
+    }
+    _last_time = now;
+    _lock.give();
+}
+
+size_t RAK3172TraceRecorder::drain(uint8_t* buf, size_t size)
+{
+    size_t done = 0;
+    if (!_lock.take()) {
+        return 0;
+    }
+    while (_used > 0) {
+        size_t tail = (_head + RAK3172_TRACE_SIZE - _used) % RAK3172_TRACE_SIZE;
+        size_t rec  = RAK3172_TRACE_HEADER_SIZE + ((at(tail + 4) | (at(tail + 5) << 8)) & TRACE_MAX_LEN);
+        if (done + rec > size) {
+            break;
+        }
+        for (size_t i = 0; i < rec; i++) {
+            buf[done + i] = at(tail + i);
+        }
+        if (_has_open && _open == tail) {
+            _has_open = false;
+        }
+        _used -= rec;
+        done += rec;
+    }
+    _lock.give();
+    return done;
+}
+
+size_t RAK3172TraceRecorder::size()
+{
+    return _used;
+}
+
+uint32_t RAK3172TraceRecorder::overruns()
+{
+    return _overruns;
+}
+
+void RAK3172TraceRecorder::clear()
+{
+    if (_lock.take()) {
+        _used     = 0;
+        _has_open = false;
+        _lock.give();
+    }
+}
+
+int RAK3172TraceRecorder::available()
+{
+    return _transport->available();
+}
+
+int RAK3172TraceRecorder::read()
+{
+    int c = _transport->read();
+    if (c >= 0) {
+        uint8_t b = c;
+        record(true, &b, 1);
+    }
+    return c;
+}
+
+int RAK3172TraceRecorder::read(uint32_t timeout_ms)
+{
+    int c = _transport->read(timeout_ms);
+    if (c >= 0) {
+        uint8_t b = c;
+        record(true, &b, 1);
+    }
+    return c;
+}
+
+bool RAK3172TraceRecorder::waitAvailable(uint32_t timeout_ms)
+{
+    return _transport->waitAvailable(timeout_ms);
+}
+
+size_t RAK3172TraceRecorder::write(const uint8_t* buf, size_t size)
+{
+    size_t n = _transport->write(buf, size);
+    record(false, buf, n);
+    return n;
+}
+
+void RAK3172TraceRecorder::flush()
+{
+    _transport->flush();
+}
+
+bool RAK3172TraceRecorder::setBaudRate(uint32_t baud)
+{
+    return _transport->setBaudRate(baud);
+}
+
+RAK3172TraceReplay::RAK3172TraceReplay(const uint8_t* trace, size_t size, bool realtime)
+    : _trace(trace),
+      _size(size),
+      _realtime(realtime),
+      _started(false),
+      _start_us(0),
+      _first_us(0),
+      _rx_rec(0),
+      _rx_pos(0),
+      _tx_before(0),
+      _tx_rec(0),
+      _tx_pos(0),
+      _tx_written(0),
+      _mismatches(0)
+{
+    bool rx;
+    size_t len;
+    header(0, &_first_us, &rx, &len);
+}
+
+bool RAK3172TraceReplay::header(size_t offset, uint32_t* time_us, bool* rx, size_t* len)
+{
+    if (offset + RAK3172_TRACE_HEADER_SIZE > _size) {
+        return false;
+    }
+    const uint8_t* p = _trace + offset;
+    uint16_t info    = p[4] | (p[5] << 8);
+    *time_us         = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    *rx              = (info & TRACE_RX) != 0;
+    *len             = info & TRACE_MAX_LEN;
+    return offset + RAK3172_TRACE_HEADER_SIZE + *len <= _size;
+}
+
+size_t RAK3172TraceReplay::ready()
+{
+    uint32_t time_us;
+    bool rx;
+    size_t len;
+    for (;;) {
+        if (!header(_rx_rec, &time_us, &rx, &len)) {
+            return 0;
+        }
+        if (rx && _rx_pos < len) {
+            break;
+        }
+        if (!rx) {
+            _tx_before += len;
+        }
+        _rx_rec += RAK3172_TRACE_HEADER_SIZE + len;
+        _rx_pos = 0;
+    }
+    if (_tx_written < _tx_before) {
+        return 0;
+    }
+    if (_realtime) {
+        if (!_started) {
+            _started  = true;
+            _start_us = micros();
+        }
+        if ((uint32_t)(micros() - _start_us) < time_us - _first_us) {
+            return 0;
+        }
+    }
+    return len - _rx_pos;
+}
+
+bool RAK3172TraceReplay::done()
+{
+    uint32_t time_us;
+    bool rx;
+    size_t len;
+    ready();
+    return !header(_rx_rec, &time_us, &rx, &len);
+}
+
+uint32_t RAK3172TraceReplay::mismatches()
+{
+    return _mismatches;
+}
+
+void RAK3172TraceReplay::rewind(size_t offset)
+{
+    bool rx;
+    size_t len;
+    _started    = false;
+    _rx_rec     = offset;
+    _rx_pos     = 0;
+    _tx_before  = 0;
+    _tx_rec     = offset;
+    _tx_pos     = 0;
+    _tx_written = 0;
+    _mismatches = 0;
+    header(offset, &_first_us, &rx, &len);
+}
+
+int RAK3172TraceReplay::available()
+{
+    return ready();
+}
+
+int RAK3172TraceReplay::read()
+{
+    if (ready() == 0) {
+        return -1;
+    }
+    return _trace[_rx_rec + RAK3172_TRACE_HEADER_SIZE + _rx_pos++];
+}
+
+size_t RAK3172TraceReplay::write(const uint8_t* buf, size_t size)
+{
+    uint32_t time_us;
+    bool rx;
+    size_t len;
+    if (_realtime && !_started) {
+        _started  = true;
+        _start_us = micros();
+    }
+    for (size_t i = 0; i < size; i++) {
+        // Find the next recorded TX byte.
+        while (header(_tx_rec, &time_us, &rx, &len) && (rx || _tx_pos >= len)) {
+            _tx_rec += RAK3172_TRACE_HEADER_SIZE + len;
+            _tx_pos = 0;
+        }
+        if (!header(_tx_rec, &time_us, &rx, &len) ||
+            _trace[_tx_rec + RAK3172_TRACE_HEADER_SIZE + _tx_pos++] != buf[i]) {
+            _mismatches++;
+        }
+        _tx_written++;
+    }
+    return size;
+}
+
+bool RAK3172TraceReplay::setBaudRate(uint32_t baud)
+{
+    return true;
+}
@@ -0,0 +1,192 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#ifndef _RAK3172_TRACE_HPP_
+#define _RAK3172_TRACE_HPP_
+
+#include <Arduino.h>
+#include "rak3172_transport.hpp"
+
+/**
+ * @def RAK3172_TRACE_SIZE
+ * @brief Size in bytes of the ring buffer of `RAK3172TraceRecorder`.
+ */
+#ifndef RAK3172_TRACE_SIZE
+#define RAK3172_TRACE_SIZE 4096
+#endif
+
+/**
+ * @def RAK3172_TRACE_GAP_US
+ * @brief Bytes in the same direction closer than this are merged into one trace record.
+ */
+#ifndef RAK3172_TRACE_GAP_US
+#define RAK3172_TRACE_GAP_US 1000
+#endif
+
+/**
+ * @def RAK3172_TRACE_HEADER_SIZE
+ * @brief Size of a trace record header.
+ *
+ * A trace is a plain sequence of records, each made of:
+ * - `uint32_t time_us`: `micros()` when the first byte was transferred, little-endian;
+ * - `uint16_t info`: bit 15 set for bytes received from the module (RX), clear for bytes
+ *   sent to it (TX); bits 0-14 hold the number of data bytes, little-endian;
+ * - the data bytes.
+ */
+#define RAK3172_TRACE_HEADER_SIZE 6
+
+/**
+ * @brief Transport wrapper recording all UART traffic into a compact binary trace.
+ *
+ * The recorder sits between the driver and the real transport, so nothing is recorded
+ * and nothing is paid when it is not used. Records are kept in a ring buffer of
+ * `RAK3172_TRACE_SIZE` bytes; when it is full the oldest records are dropped. Unlike
+ * `RAK3172_DEBUG`, recording only copies bytes into RAM and does not change timing.
+ *
+ * @code
+ * RAK3172SerialTransport uart;
+ * RAK3172TraceRecorder recorder(&uart);
+ * uart.begin(&Serial2, 115200, 16, 17);
+ * lorawan.init(&recorder);
+ * ...
+ * uint8_t buf[512];
+ * size_t n = recorder.drain(buf, sizeof(buf));  // store or upload the trace
+ * @endcode
+ */
+class RAK3172TraceRecorder : public RAK3172Transport {
+public:
+    /**
+     * @param transport The transport connected to the module.
+     */
+    explicit RAK3172TraceRecorder(RAK3172Transport* transport);
+
+    /**
+     * @brief Pauses or resumes recording (recording is on by default).
+     */
+    void enable(bool enable);
+
+    /**
+     * @brief Moves the oldest complete records into `buf` and removes them from the ring.
+     *
+     * @param buf Destination buffer.
+     * @param size The size of the destination buffer.
+     * @return The number of bytes written to `buf`, always a whole number of records.
+     */
+    size_t drain(uint8_t* buf, size_t size);
+
+    /**
+     * @brief Returns the number of trace bytes currently stored.
+     */
+    size_t size();
+
+    /**
+     * @brief Returns the number of records dropped because the ring was full.
+     */
+    uint32_t overruns();
+
+    /**
+     * @brief Discards all stored records.
+     */
+    void clear();
+
+    int available() override;
+    int read() override;
+    int read(uint32_t timeout_ms) override;
+    bool waitAvailable(uint32_t timeout_ms) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    void flush() override;
+    bool setBaudRate(uint32_t baud) override;
+    using RAK3172Transport::write;
+
+private:
+    void record(bool rx, const uint8_t* data, size_t len);
+    uint8_t at(size_t offset);
+    void put(size_t offset, uint8_t value);
+    void evict();
+
+    RAK3172Transport* _transport;
+    RAK3172Lock _lock;
+    uint8_t _buf[RAK3172_TRACE_SIZE];
+    size_t _head;
+    size_t _used;
+    size_t _open;
+    bool _open_rx;
+    bool _has_open;
+    uint32_t _last_time;
+    uint32_t _overruns;
+    bool _enabled;
+};
+
+/**
+ * @brief Transport that plays back a trace recorded by `RAK3172TraceRecorder`.
+ *
+ * Passing it to `init(RAK3172Transport*)` runs the recorded module output through the
+ * real line demultiplexer, event handlers and frame parser, which turns a field capture
+ * into a deterministic regression test or a parser benchmark:
+ * - Received bytes are released in trace order. An RX record that followed a TX record
+ *   is only released once the driver has written as many bytes as the trace had sent,
+ *   so responses never overtake the commands they answer.
+ * - In real-time mode records are also held back until their recorded time offset has
+ *   elapsed; otherwise the trace is played at full speed.
+ * - Written bytes are compared with the recorded TX bytes, see `mismatches()`.
+ */
+class RAK3172TraceReplay : public RAK3172Transport {
+public:
+    /**
+     * @param trace The recorded trace; must stay valid while it is played.
+     * @param size The size of the trace in bytes.
+     * @param realtime `true` to reproduce the recorded timing.
+     */
+    RAK3172TraceReplay(const uint8_t* trace, size_t size, bool realtime = false);
+
+    /**
+     * @brief Returns true once every recorded RX byte has been read.
+     */
+    bool done();
+
+    /**
+     * @brief Returns the number of written bytes that differ from the recorded TX bytes.
+     */
+    uint32_t mismatches();
+
+    /**
+     * @brief Restarts playback at the record starting at byte `offset` of the trace.
+     *
+     * The bytes before `offset` count as already exchanged, so a trace whose first part
+     * was consumed by `init()` can play its remaining records in a loop. The mismatch
+     * count is cleared.
+     *
+     * @param offset Offset of a record header, 0 to restart from the beginning.
+     */
+    void rewind(size_t offset = 0);
+
+    int available() override;
+    int read() override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    bool setBaudRate(uint32_t baud) override;
+    using RAK3172Transport::read;
+    using RAK3172Transport::write;
+
+private:
+    bool header(size_t offset, uint32_t* time_us, bool* rx, size_t* len);
+    size_t ready();
+
+    const uint8_t* _trace;
+    size_t _size;
+    bool _realtime;
+    bool _started;
+    uint32_t _start_us;
+    uint32_t _first_us;
+    size_t _rx_rec;
+    size_t _rx_pos;
+    size_t _tx_before;
+    size_t _tx_rec;
+    size_t _tx_pos;
+    size_t _tx_written;
+    uint32_t _mismatches;
+};
+
+#endif
@@ -0,0 +1,327 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#include "rak3172_transport.hpp"
+
+#if defined RAK3172_USE_POSIX
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+int RAK3172Transport::read(uint32_t timeout_ms)
+{
+    uint32_t start = millis();
+    for (;;) {
+        int c = read();
+        if (c >= 0) {
+            return c;
+        }
+        if ((uint32_t)(millis() - start) >= timeout_ms) {
+            return -1;
+        }
+        delay(1);
+    }
+}
+
+bool RAK3172Transport::waitAvailable(uint32_t timeout_ms)
+{
+    uint32_t start = millis();
+    while (available() <= 0) {
+        if ((uint32_t)(millis() - start) >= timeout_ms) {
+            return false;
+        }
+        delay(1);
+    }
+    return true;
+}
+
+#if defined RAK3172_USE_FREERTOS
+RAK3172Lock::RAK3172Lock()
+{
+    _mutex = xSemaphoreCreateMutex();
+}
+
+RAK3172Lock::~RAK3172Lock()
+{
+    vSemaphoreDelete(_mutex);
+}
+
+bool RAK3172Lock::take()
+{
+    return xSemaphoreTake(_mutex, portMAX_DELAY) == pdTRUE;
+}
+
+void RAK3172Lock::give()
+{
+    xSemaphoreGive(_mutex);
+}
+
+void RAK3172SerialTransport::begin(HardwareSerial* serial, uint32_t baud, int rx, int tx)
+{
+    _serial = serial;
+    _serial->setTimeout(200);
+    _serial->begin(baud, SERIAL_8N1, rx, tx);
+    if (_rx_event == nullptr) {
+        _rx_event = xSemaphoreCreateBinary();
+    }
+    if (_rx_event != nullptr) {
+        SemaphoreHandle_t rx_event = _rx_event;
+        _serial->onReceive([rx_event]() { xSemaphoreGive(rx_event); });
+    }
+}
+
+int RAK3172SerialTransport::available()
+{
+    return _serial->available();
+}
+
+int RAK3172SerialTransport::read()
+{
+    return _serial->read();
+}
+
+bool RAK3172SerialTransport::waitAvailable(uint32_t timeout_ms)
+{
+    if (_rx_event == nullptr) {
+        return RAK3172Transport::waitAvailable(timeout_ms);
+    }
+    if (_serial->available() > 0) {
+        return true;
+    }
+    return xSemaphoreTake(_rx_event, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+size_t RAK3172SerialTransport::write(const uint8_t* buf, size_t size)
+{
+    return _serial->write(buf, size);
+}
+
+void RAK3172SerialTransport::flush()
+{
+    _serial->flush();
+}
+
+bool RAK3172SerialTransport::setBaudRate(uint32_t baud)
+{
+    _serial->updateBaudRate(baud);
+    return true;
+}
+#endif
+
+#if defined RAK3172_USE_POSIX
+RAK3172Lock::RAK3172Lock()
+{
+    pthread_mutex_init(&_mutex, nullptr);
+}
+
+RAK3172Lock::~RAK3172Lock()
+{
+    pthread_mutex_destroy(&_mutex);
+}
+
+bool RAK3172Lock::take()
+{
+    return pthread_mutex_lock(&_mutex) == 0;
+}
+
+void RAK3172Lock::give()
+{
+    pthread_mutex_unlock(&_mutex);
+}
+
+static speed_t baud2speed(uint32_t baud)
+{
+    switch (baud) {
+        case 4800:
+            return B4800;
+        case 9600:
+            return B9600;
+        case 19200:
+            return B19200;
+        case 38400:
+            return B38400;
+        case 57600:
+            return B57600;
+        case 115200:
+            return B115200;
+        default:
+            return B0;
+    }
+}
+
+RAK3172PosixTransport::RAK3172PosixTransport() : _fd(-1), _pos(0), _len(0)
+{
+}
+
+RAK3172PosixTransport::~RAK3172PosixTransport()
+{
+    close();
+}
+
+bool RAK3172PosixTransport::open(const char* path, uint32_t baud)
+{
+    int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return false;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        ::close(fd);
+        return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN]  = 0;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0 || !attach(fd)) {
+        ::close(fd);
+        _fd = -1;
+        return false;
+    }
+    return setBaudRate(baud);
+}
+
+bool RAK3172PosixTransport::attach(int fd)
+{
+    close();
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+        return false;
+    }
+    _fd = fd;
+    _lock.take();
+    _pos = 0;
+    _len = 0;
+    _lock.give();
+    return true;
+}
+
+void RAK3172PosixTransport::close()
+{
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _lock.take();
+    _pos = 0;
+    _len = 0;
+    _lock.give();
+}
+
+bool RAK3172PosixTransport::fill()
+{
+    if (_pos < _len) {
+        return true;
+    }
+    if (_fd < 0) {
+        return false;
+    }
+    ssize_t n = ::read(_fd, _buf, sizeof(_buf));
+    if (n <= 0) {
+        return false;
+    }
+    _pos = 0;
+    _len = n;
+    return true;
+}
+
+bool RAK3172PosixTransport::pollInput(uint32_t timeout_ms)
+{
+    if (_fd < 0) {
+        return false;
+    }
+    struct pollfd pfd = {_fd, POLLIN, 0};
+    int n;
+    while ((n = poll(&pfd, 1, timeout_ms > INT32_MAX ? -1 : (int)timeout_ms)) < 0 && errno == EINTR) {
+    }
+    return n > 0 && (pfd.revents & POLLIN) != 0;
+}
+
+int RAK3172PosixTransport::available()
+{
+    int n = 0;
+    if (_fd >= 0 && ioctl(_fd, FIONREAD, &n) != 0) {
+        n = 0;
+    }
+    _lock.take();
+    n += _len - _pos;
+    _lock.give();
+    return n;
+}
+
+int RAK3172PosixTransport::read()
+{
+    _lock.take();
+    int c = fill() ? _buf[_pos++] : -1;
+    _lock.give();
+    return c;
+}
+
+int RAK3172PosixTransport::read(uint32_t timeout_ms)
+{
+    int c = read();
+    if (c >= 0 || timeout_ms == 0 || !pollInput(timeout_ms)) {
+        return c;
+    }
+    return read();
+}
+
+bool RAK3172PosixTransport::waitAvailable(uint32_t timeout_ms)
+{
+    // Bytes already buffered by an earlier read() do not wake poll().
+    _lock.take();
+    bool buffered = _pos < _len;
+    _lock.give();
+    return buffered || pollInput(timeout_ms);
+}
+
+size_t RAK3172PosixTransport::write(const uint8_t* buf, size_t size)
+{
+    size_t done = 0;
+    while (_fd >= 0 && done < size) {
+        ssize_t n = ::write(_fd, buf + done, size - done);
+        if (n > 0) {
+            done += n;
+        } else if (n < 0 && errno == EAGAIN) {
+            struct pollfd pfd = {_fd, POLLOUT, 0};
+            if (poll(&pfd, 1, 1000) <= 0) {
+                break;
+            }
+        } else if (n < 0 && errno != EINTR) {
+            break;
+        }
+    }
+    return done;
+}
+
+void RAK3172PosixTransport::flush()
+{
+    if (_fd >= 0) {
+        tcdrain(_fd);
+    }
+}
+
+bool RAK3172PosixTransport::setBaudRate(uint32_t baud)
+{
+    struct termios tio;
+    speed_t speed = baud2speed(baud);
+    if (_fd < 0 || speed == B0) {
+        return false;
+    }
+    if (tcgetattr(_fd, &tio) != 0) {
+        // Not a tty (e.g. a socket or pipe), there is no baud rate to set.
+        return true;
+    }
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    return tcsetattr(_fd, TCSANOW, &tio) == 0;
+}
+#endif
@@ -0,0 +1,273 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#ifndef _RAK3172_TRANSPORT_HPP_
+#define _RAK3172_TRANSPORT_HPP_
+
+#include <Arduino.h>
+
+/**
+ * @def RAK3172_USE_FREERTOS
+ * @brief Selects the ESP32 backends: `HardwareSerial` transport, FreeRTOS mutex and worker tasks.
+ *
+ * @def RAK3172_USE_POSIX
+ * @brief Selects the Linux backends: termios transport and pthread mutex.
+ *
+ * One of them is chosen automatically from the target; define either one to override it.
+ */
+#if !defined RAK3172_USE_FREERTOS && !defined RAK3172_USE_POSIX
+#if defined ESP_PLATFORM || defined ARDUINO_ARCH_ESP32
+#define RAK3172_USE_FREERTOS
+#elif defined __unix__
+#define RAK3172_USE_POSIX
+#else
+#error "M5-LoRaWAN-RAK: no transport backend for this platform"
+#endif
+#endif
+
+#if defined RAK3172_USE_POSIX
+#include <pthread.h>
+#endif
+
+/**
+ * @brief Byte stream connecting the driver to the RAK3172 module.
+ *
+ * The driver only needs to write bytes and to read them back with a deadline, so any
+ * UART, USB-UART or pseudo terminal can be used by implementing this interface.
+ */
+class RAK3172Transport {
+public:
+    virtual ~RAK3172Transport()
+    {
+    }
+
+    /**
+     * @brief Returns the number of bytes that can be read without waiting.
+     */
+    virtual int available() = 0;
+
+    /**
+     * @brief Reads one byte without waiting.
+     *
+     * @return The byte, or -1 if no byte is available.
+     */
+    virtual int read() = 0;
+
+    /**
+     * @brief Reads one byte, waiting at most `timeout_ms` for it to arrive.
+     *
+     * The default implementation polls `read()` once per millisecond; backends that can
+     * block on the device should override it.
+     *
+     * @param timeout_ms Maximum time to wait in milliseconds.
+     * @return The byte, or -1 if the timeout expired.
+     */
+    virtual int read(uint32_t timeout_ms);
+
+    /**
+     * @brief Waits until bytes can be read, without reading them.
+     *
+     * Used by the receive task (see `RAK3172::beginReceive()`) to sleep while the module
+     * is silent. The default implementation polls `available()` once per millisecond;
+     * backends that can be notified of incoming data should override it.
+     *
+     * @param timeout_ms Maximum time to wait in milliseconds.
+     * @return `true` if bytes may be available, `false` if the timeout expired.
+     */
+    virtual bool waitAvailable(uint32_t timeout_ms);
+
+    /**
+     * @brief Writes bytes to the module.
+     *
+     * @param buf Pointer to the bytes to be written.
+     * @param size The number of bytes.
+     * @return The number of bytes written.
+     */
+    virtual size_t write(const uint8_t* buf, size_t size) = 0;
+
+    /**
+     * @brief Waits until all written bytes have been transmitted.
+     */
+    virtual void flush()
+    {
+    }
+
+    /**
+     * @brief Changes the baud rate of the link.
+     *
+     * @param baud The new baud rate in bps.
+     * @return `true` if the baud rate was changed.
+     */
+    virtual bool setBaudRate(uint32_t baud)
+    {
+        return false;
+    }
+
+    /**
+     * @brief Writes a null-terminated string, see `write(const uint8_t*, size_t)`.
+     */
+    size_t write(const char* str)
+    {
+        return write((const uint8_t*)str, strlen(str));
+    }
+};
+
+/**
+ * @brief Mutex serializing access to the transport.
+ *
+ * Backed by a FreeRTOS mutex on ESP32 and by a pthread mutex on Linux.
+ */
+class RAK3172Lock {
+public:
+    RAK3172Lock();
+    ~RAK3172Lock();
+
+    /**
+     * @brief Takes the lock, waiting as long as necessary.
+     *
+     * @return `true` once the lock is held.
+     */
+    bool take();
+
+    /**
+     * @brief Releases the lock.
+     */
+    void give();
+
+private:
+#if defined RAK3172_USE_FREERTOS
+    SemaphoreHandle_t _mutex;
+#else
+    pthread_mutex_t _mutex;
+#endif
+};
+
+#if defined RAK3172_USE_FREERTOS
+/**
+ * @brief Transport over an ESP32 `HardwareSerial` port.
+ *
+ * `waitAvailable()` blocks on a semaphore given by the UART receive callback, so a task
+ * waiting for data does not run until bytes arrive.
+ */
+class RAK3172SerialTransport : public RAK3172Transport {
+public:
+    RAK3172SerialTransport() : _serial(nullptr), _rx_event(nullptr)
+    {
+    }
+
+    /**
+     * @brief Starts the serial port.
+     *
+     * @param serial The serial port connected to the module.
+     * @param baud The baud rate in bps.
+     * @param rx The RX pin number.
+     * @param tx The TX pin number.
+     */
+    void begin(HardwareSerial* serial, uint32_t baud, int rx, int tx);
+
+    int available() override;
+    int read() override;
+    bool waitAvailable(uint32_t timeout_ms) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    void flush() override;
+    bool setBaudRate(uint32_t baud) override;
+    using RAK3172Transport::read;
+    using RAK3172Transport::write;
+
+    /**
+     * @brief Returns the serial port passed to `begin()`.
+     */
+    HardwareSerial* serial()
+    {
+        return _serial;
+    }
+
+private:
+    HardwareSerial* _serial;
+    SemaphoreHandle_t _rx_event;
+};
+#endif
+
+#if defined RAK3172_USE_POSIX
+/**
+ * @brief Transport over a Linux tty (USB-UART, `/dev/ttyS*`, pseudo terminal).
+ *
+ * The device is configured in raw 8N1 mode. Received bytes are read in blocks into a
+ * small buffer; `read(uint32_t)` and `waitAvailable()` sleep in `poll()` instead of spinning.
+ */
+class RAK3172PosixTransport : public RAK3172Transport {
+public:
+    RAK3172PosixTransport();
+    ~RAK3172PosixTransport();
+
+    /**
+     * @brief Opens and configures a tty device.
+     *
+     * @param path The device path, e.g. `/dev/ttyUSB0`.
+     * @param baud The baud rate in bps.
+     * @return `true` if the device was opened and configured.
+     */
+    bool open(const char* path, uint32_t baud = 115200);
+
+    /**
+     * @brief Uses an already opened file descriptor, e.g. the master side of a pty.
+     *
+     * The descriptor is switched to non-blocking mode and closed by `close()`.
+     *
+     * @param fd The file descriptor.
+     * @return `true` if the descriptor is usable.
+     */
+    bool attach(int fd);
+
+    /**
+     * @brief Closes the device.
+     */
+    void close();
+
+    int available() override;
+    int read() override;
+    int read(uint32_t timeout_ms) override;
+    bool waitAvailable(uint32_t timeout_ms) override;
+    size_t write(const uint8_t* buf, size_t size) override;
+    void flush() override;
+    bool setBaudRate(uint32_t baud) override;
+    using RAK3172Transport::write;
+
+    /**
+     * @brief Returns the file descriptor, or -1 if the device is not open.
+     */
+    int fd()
+    {
+        return _fd;
+    }
+
+private:
+    /**
+     * @brief Refills the receive buffer without blocking. Called with `_lock` held.
+     *
+     * @return `true` if at least one byte is buffered.
+     */
+    bool fill();
+
+    /**
+     * @brief Waits in `poll()` until the device is readable, without holding `_lock`.
+     */
+    bool pollInput(uint32_t timeout_ms);
+
+    int _fd;
+
+    /**
+     * @brief Receive buffer, protected by `_lock` so `waitAvailable()` can run in the
+     *        receive task while another task reads.
+     */
+    RAK3172Lock _lock;
+    uint8_t _buf[256];
+    size_t _pos;
+    size_t _len;
+};
+#endif
+
+#endif
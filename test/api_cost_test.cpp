@@ -0,0 +1,456 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file api_cost_test.cpp
+ * @brief Round trips, bytes on the wire and heap allocations of the public API.
+ *
+ * The driver talks to `RAK3172Emulator` through `WireCounter`, which counts the bytes in
+ * both directions. Every check pins the cost of one API call, so a change that adds a
+ * command, a byte or an allocation to a hot path fails here.
+ */
+#include "host_test.h"
+#include "rak3172_emulator.hpp"
+#include "rak3172_lorawan.hpp"
+#include "rak3172_p2p.hpp"
+
+/**
+ * @brief Transport counting the bytes exchanged with the emulator.
+ */
+class WireCounter : public RAK3172Transport {
+public:
+    int available() override
+    {
+        return emulator.available();
+    }
+
+    int read() override
+    {
+        int c = emulator.read();
+        if (c >= 0) {
+            rx_bytes++;
+        }
+        return c;
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override
+    {
+        tx_bytes += size;
+        return emulator.write(buf, size);
+    }
+
+    bool setBaudRate(uint32_t baud) override
+    {
+        return emulator.setBaudRate(baud);
+    }
+
+    using RAK3172Transport::read;
+    using RAK3172Transport::write;
+
+    RAK3172Emulator emulator;
+    uint64_t tx_bytes = 0;
+    uint64_t rx_bytes = 0;
+};
+
+/**
+ * @brief Cost of the calls made since `begin()`.
+ */
+typedef struct {
+    uint32_t commands;
+    uint64_t tx_bytes;
+    uint64_t rx_bytes;
+    uint64_t allocs;
+} cost_t;
+
+class CostMeter {
+public:
+    explicit CostMeter(WireCounter& wire) : _wire(wire)
+    {
+    }
+
+    void begin()
+    {
+        _commands = _wire.emulator.commands();
+        _tx_bytes = _wire.tx_bytes;
+        _rx_bytes = _wire.rx_bytes;
+        allocReset();
+    }
+
+    cost_t end()
+    {
+        return {_wire.emulator.commands() - _commands, _wire.tx_bytes - _tx_bytes, _wire.rx_bytes - _rx_bytes,
+                allocStats().allocs};
+    }
+
+private:
+    WireCounter& _wire;
+    uint32_t _commands;
+    uint64_t _tx_bytes;
+    uint64_t _rx_bytes;
+};
+
+static const char* DEVEUI = "70B3D57ED0000001";
+static const char* APPEUI = "0000000000000000";
+static const char* APPKEY = "00112233445566778899AABBCCDDEEFF";
+
+static bool waitFrame(RAK3172LoRaWAN& lorawan)
+{
+    uint32_t start = millis();
+    while (lorawan.available() == 0 && millis() - start < 1000) {
+        lorawan.update();
+        delay(1);
+    }
+    return lorawan.available() > 0;
+}
+
+static void testLoRaWANConfig()
+{
+    static WireCounter wire;
+    static RAK3172LoRaWAN lorawan;
+    CostMeter meter(wire);
+    cost_t cost;
+    uint8_t dr;
+    uint8_t deveui[8];
+    char value[64];
+    rak3172_result_t result;
+
+    CHECK(lorawan.init(&wire));
+
+    // Setters are formatted on the stack: one command each, no heap.
+    meter.begin();
+    CHECK(lorawan.setOTAA(DEVEUI, APPEUI, APPKEY));
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 4);
+    CHECK_EQ(cost.tx_bytes, strlen("AT+NJM=1\r\n") + strlen("AT+DEVEUI=\r\n") + 16 + strlen("AT+APPEUI=\r\n") + 16 +
+                                strlen("AT+APPKEY=\r\n") + 32);
+    CHECK_EQ(cost.allocs, 0);
+
+    meter.begin();
+    CHECK(lorawan.setBAND(US915, "0001"));
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 2);
+    CHECK_EQ(cost.tx_bytes, strlen("AT+BAND=5\r\n") + strlen("AT+MASK=0001\r\n"));
+    CHECK_EQ(cost.allocs, 0);
+
+    meter.begin();
+    CHECK(lorawan.setDR(3));
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 1);
+    CHECK_EQ(cost.tx_bytes, strlen("AT+DR=3\r\n"));
+    CHECK_EQ(cost.rx_bytes, strlen("OK\r\n"));
+    CHECK_EQ(cost.allocs, 0);
+
+    // Responses are parsed in place on the final result line.
+    meter.begin();
+    CHECK(lorawan.getDR(dr));
+    cost = meter.end();
+    CHECK_EQ(dr, 3);
+    CHECK_EQ(cost.commands, 1);
+    CHECK_EQ(cost.tx_bytes, strlen("AT+DR=?\r\n"));
+    CHECK_EQ(cost.rx_bytes, strlen("AT+DR=3\r\nOK\r\n"));
+    CHECK_EQ(cost.allocs, 0);
+
+    meter.begin();
+    CHECK(lorawan.getDevEUI(deveui));
+    cost = meter.end();
+    CHECK_EQ(deveui[0], 0x70);
+    CHECK_EQ(deveui[7], 0x01);
+    CHECK_EQ(cost.commands, 1);
+    CHECK_EQ(cost.allocs, 0);
+
+    meter.begin();
+    CHECK(lorawan.getCommand("AT+DR=?", value, sizeof(value)));
+    cost = meter.end();
+    CHECK(strcmp(value, "3") == 0);
+    CHECK_EQ(cost.allocs, 0);
+
+    // The call reports its own result, also for an empty value.
+    CHECK(!lorawan.getCommand("AT+ALIAS=?", value, sizeof(value), RAK3172_COMMAND_TIMEOUT, &result));
+    CHECK_EQ(result, RAK3172_RESULT_OK);
+    CHECK(!lorawan.getCommand("ATI", value, sizeof(value), RAK3172_COMMAND_TIMEOUT, &result));
+    CHECK_EQ(result, RAK3172_RESULT_COMMAND_NOT_FOUND);
+
+    // The String overload only pays for the returned value.
+    meter.begin();
+    {
+        String ver = lorawan.getCommand("AT+DR=?");
+        CHECK(ver == "3");
+    }
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 1);
+    CHECK_EQ(cost.allocs, 1);
+
+#if RAK3172_CACHE_SIZE > 0
+    // Cached queries and setters that change nothing skip the round trip.
+    lorawan.enableCache(true);
+    lorawan.enableDiffApply(true);
+    CHECK(lorawan.getDR(dr));
+    meter.begin();
+    CHECK(lorawan.getDR(dr));
+    CHECK(lorawan.setDR(3));
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 0);
+    CHECK_EQ(cost.tx_bytes, 0);
+    CHECK_EQ(cost.allocs, 0);
+
+    // ADR may change the data rate with every uplink, so DR is read again afterwards.
+    CHECK(wire.emulator.injectEvent("+EVT:TX_DONE"));
+    delay(1);
+    lorawan.update();
+    meter.begin();
+    CHECK(lorawan.getDR(dr));
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 1);
+
+    // An empty value is a valid answer: the query is sent once, then served from the cache.
+    CHECK(lorawan.sendCommand("AT+ALIAS="));
+    meter.begin();
+    CHECK(lorawan.sendCommand("AT+ALIAS="));
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 0);
+    CHECK(lorawan.refreshCache());
+
+    lorawan.enableCache(false);
+    lorawan.enableDiffApply(false);
+#endif
+}
+
+static void testLoRaWANTraffic()
+{
+    static WireCounter wire;
+    static RAK3172LoRaWAN lorawan;
+    CostMeter meter(wire);
+    cost_t cost;
+    uint8_t payload[242];
+    lorawan_snapshot_t snapshot;
+    const lorawan_frame_t* frame;
+
+    CHECK(lorawan.init(&wire));
+    CHECK(lorawan.setOTAA(DEVEUI, APPEUI, APPKEY));
+    wire.emulator.setJoinResult(0);
+    CHECK(lorawan.join());
+    delay(5);
+    lorawan.update();
+
+    // Uplinks are hex-encoded while they are written: one command, no heap, at any size.
+    memset(payload, 0xA5, sizeof(payload));
+    for (size_t size : {(size_t)1, (size_t)64, sizeof(payload)}) {
+        meter.begin();
+        CHECK_EQ(lorawan.send(payload, size, 2), size);
+        cost = meter.end();
+        CHECK_EQ(cost.commands, 1);
+        CHECK_EQ(cost.tx_bytes, strlen("AT+SEND=2:\r\n") + 2 * size);
+        CHECK_EQ(cost.rx_bytes, strlen("OK\r\n"));
+        CHECK_EQ(cost.allocs, 0);
+        delay(60);
+        lorawan.update();
+    }
+
+    // Events are queued in fixed line slots and frames in a fixed ring.
+    CHECK(wire.emulator.injectEvent("+EVT:RX_1:-40:8:UNICAST:2:cafe"));
+    allocReset();
+    CHECK(waitFrame(lorawan));
+    frame = lorawan.peek();
+    CHECK(frame != nullptr);
+    if (frame != nullptr) {
+        CHECK_EQ(frame->port, 2);
+        CHECK_EQ(frame->len, 2);
+        CHECK_EQ((uint8_t)frame->payload[0], 0xCA);
+    }
+    lorawan.pop();
+    CHECK_EQ(allocStats().allocs, 0);
+
+    allocReset();
+    lorawan.parse("+EVT:RX_1:-40:8:UNICAST:2:cafe", strlen("+EVT:RX_1:-40:8:UNICAST:2:cafe"));
+    CHECK_EQ(lorawan.available(), 1);
+    lorawan.pop();
+    CHECK_EQ(allocStats().allocs, 0);
+
+    // The configuration is read in one pipelined pass without heap.
+    meter.begin();
+    lorawan.snapshot(&snapshot);
+    cost = meter.end();
+    CHECK(strcmp(snapshot.deveui, DEVEUI) == 0);
+    CHECK_EQ(cost.commands, 25);
+    CHECK_EQ(cost.allocs, 0);
+}
+
+/**
+ * @brief Errors reported to `RAK3172P2P::onError()`.
+ */
+typedef struct {
+    int count;
+    char last[32];
+} p2p_errors_t;
+
+static void onP2PError(const char* error, void* ctx)
+{
+    p2p_errors_t* errors = (p2p_errors_t*)ctx;
+    errors->count++;
+    snprintf(errors->last, sizeof(errors->last), "%s", error);
+}
+
+static void testP2P()
+{
+    static WireCounter wire;
+    static RAK3172P2P p2p;
+    CostMeter meter(wire);
+    cost_t cost;
+    uint8_t payload[16] = {0x01, 0x02, 0x03};
+    const p2p_frame_t* frame;
+    p2p_errors_t errors = {};
+
+    CHECK(p2p.init(&wire));
+
+    meter.begin();
+    CHECK(p2p.config(868000000, 7, 0, 0, 8, 14));
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 1);
+    CHECK_EQ(cost.allocs, 0);
+
+    meter.begin();
+    CHECK_EQ(p2p.write(payload, sizeof(payload)), sizeof(payload));
+    cost = meter.end();
+    CHECK_EQ(cost.commands, 1);
+    CHECK_EQ(cost.tx_bytes, strlen("AT+PSEND=\r\n") + 2 * sizeof(payload));
+    CHECK_EQ(cost.allocs, 0);
+
+    allocReset();
+    p2p.parse("+EVT:RXP2P:-40:8:010203", strlen("+EVT:RXP2P:-40:8:010203"));
+    frame = p2p.peek();
+    CHECK(frame != nullptr);
+    if (frame != nullptr) {
+        CHECK_EQ(frame->len, 3);
+        CHECK_EQ((uint8_t)frame->payload[2], 0x03);
+    }
+    p2p.pop();
+    CHECK_EQ(allocStats().allocs, 0);
+
+    // Reception errors and timeouts reach onError() without heap.
+    p2p.onError(onP2PError, &errors);
+    CHECK(wire.emulator.injectEvent("+EVT:RXP2P RECEIVE TIMEOUT"));
+    allocReset();
+    for (uint32_t start = millis(); errors.count == 0 && millis() - start < 1000;) {
+        p2p.update();
+        delay(1);
+    }
+    CHECK_EQ(errors.count, 1);
+    CHECK(strcmp(errors.last, "RXP2P RECEIVE TIMEOUT") == 0);
+    CHECK_EQ(allocStats().allocs, 0);
+    CHECK(wire.emulator.injectEvent("+EVT:RXP2P RECEIVE ERROR"));
+    for (uint32_t start = millis(); errors.count == 1 && millis() - start < 1000;) {
+        p2p.update();
+        delay(1);
+    }
+    CHECK_EQ(errors.count, 2);
+    CHECK(strcmp(errors.last, "RXP2P RECEIVE ERROR") == 0);
+    CHECK_EQ(p2p.available(), 0);
+}
+
+/**
+ * @brief Driver feeding lines straight into the demultiplexer, as if they arrived during a command.
+ */
+class EventFeeder : public RAK3172LoRaWAN {
+public:
+    void feedLine(const char* line)
+    {
+        for (const char* p = line; *p; p++) {
+            feed(*p, nullptr);
+        }
+    }
+};
+
+/**
+ * @brief Events seen by `onEvent()`, numbered by `testEventBuffer()`.
+ */
+typedef struct {
+    int count;
+    int first;
+    int last;
+    bool ordered;
+} event_seen_t;
+
+static void onNumberedEvent(const rak3172_event_t& event, void* ctx)
+{
+    event_seen_t* seen = (event_seen_t*)ctx;
+    int n              = atoi(event.line + strlen("+EVT:TEST_"));
+    if (seen->count == 0) {
+        seen->first = n;
+    } else if (n != seen->last + 1) {
+        seen->ordered = false;
+    }
+    seen->last = n;
+    seen->count++;
+}
+
+static void testEventBuffer()
+{
+    static WireCounter wire;
+    static EventFeeder lorawan;
+    static const int LINES = 100;
+    // "+EVT:TEST_000" takes 13 bytes and a 2-byte length.
+    static const int KEPT = RAK3172_EVENT_BUFFER_SIZE / 15;
+    event_seen_t seen;
+    char line[32];
+#if RAK3172_STATS
+    rak3172_stats_t stats;
+#endif
+
+    CHECK(lorawan.init(&wire));
+    lorawan.onEvent(onNumberedEvent, &seen);
+
+    // Short events share the buffer; when it is full the oldest are dropped. The rounds
+    // start at different offsets, so the lines wrap around the end of the buffer.
+    for (int round = 0; round < 3; round++) {
+        seen = {0, 0, 0, true};
+        allocReset();
+        for (int i = 0; i < LINES; i++) {
+            snprintf(line, sizeof(line), "+EVT:TEST_%03d\r\n", i);
+            lorawan.feedLine(line);
+        }
+        lorawan.update();
+        CHECK_EQ(allocStats().allocs, 0);
+        CHECK_EQ(seen.count, KEPT);
+        CHECK_EQ(seen.first, LINES - KEPT);
+        CHECK_EQ(seen.last, LINES - 1);
+        CHECK(seen.ordered);
+    }
+#if RAK3172_STATS
+    lorawan.getStats(&stats);
+    CHECK_EQ(stats.events_dropped, 3 * (LINES - KEPT));
+#endif
+
+    // A line carrying the largest payload still fits next to the short ones.
+    static char rx[RAK3172_LINE_SIZE];
+    int len = snprintf(rx, sizeof(rx), "+EVT:RX_1:-40:8:UNICAST:2:");
+    while (len < RAK3172_LINE_SIZE - 3) {
+        rx[len++] = 'a';
+    }
+    rx[len++] = '\r';
+    rx[len++] = '\n';
+    rx[len]   = '\0';
+    seen      = {0, 0, 0, true};
+    lorawan.feedLine("+EVT:TEST_000\r\n");
+    lorawan.feedLine(rx);
+    lorawan.feedLine("+EVT:TEST_001\r\n");
+    lorawan.update();
+    CHECK_EQ(seen.count, 3);
+    CHECK_EQ(seen.first, 0);
+}
+
+int main()
+{
+    testLoRaWANConfig();
+    testLoRaWANTraffic();
+    testP2P();
+    testEventBuffer();
+    if (host_test_failures != 0) {
+        printf("%d check(s) failed\n", host_test_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file frame_queue_test.cpp
+ * @brief Two-thread stress test of `RAK3172FrameQueue` under every overflow policy.
+ *
+ * A producer thread writes frames as fast as it can while a consumer thread reads them
+ * with `front()` and `pop()`, sometimes holding a frame or handing it back with
+ * `release()`. Every frame carries its sequence number in all its words, so a frame
+ * overwritten while the consumer holds it is detected as torn. Build with
+ * `-DRAK3172_TSAN=ON` to run it under ThreadSanitizer.
+ */
+#include "host_test.h"
+#include "rak3172_queue.hpp"
+
+#include <atomic>
+#include <thread>
+
+#define FRAMES 200000
+#define WORDS  16
+
+typedef struct {
+    uint32_t word[WORDS];
+} frame_t;
+
+typedef struct {
+    uint32_t produced; /**< Frames offered to `reserve()` */
+    uint32_t consumed; /**< Frames read by the consumer */
+    uint32_t torn;     /**< Frames whose words disagree */
+    uint32_t reorder;  /**< Frames older than the previous one */
+    uint32_t gaps;     /**< Frames missing between two consumed ones */
+    uint32_t repin;    /**< `front()` after `release()` returning another frame */
+} stress_result_t;
+
+static RAK3172FrameQueue<frame_t, 8> queue;
+
+static void produce(stress_result_t* result, std::atomic<bool>* done)
+{
+    for (uint32_t seq = 1; seq <= FRAMES; seq++) {
+        if (seq % 2 == 0) {
+            // Roughly match the consumer's pace so the queue keeps filling and draining.
+            std::this_thread::yield();
+        }
+        frame_t* frame = queue.reserve();
+        result->produced++;
+        if (frame == nullptr) {
+            continue;
+        }
+        for (int i = 0; i < WORDS; i++) {
+            frame->word[i] = seq;
+        }
+        queue.commit();
+    }
+    done->store(true, std::memory_order_release);
+}
+
+static void consume(stress_result_t* result, std::atomic<bool>* done)
+{
+    uint32_t last = 0;
+    for (uint32_t n = 0;; n++) {
+        bool finished  = done->load(std::memory_order_acquire);
+        frame_t* frame = queue.front();
+        if (frame == nullptr) {
+            if (finished) {
+                return;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        uint32_t seq = frame->word[0];
+        if (n % 7 == 0) {
+            // Hand the frame back; the next front() must return the same one.
+            queue.release();
+            frame = queue.front();
+            if (frame == nullptr || frame->word[0] != seq) {
+                result->repin++;
+                continue;
+            }
+        }
+        if (n % 256 == 0) {
+            // Hold the pinned frame until the producer overflows the queue.
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        for (int i = 1; i < WORDS; i++) {
+            if (frame->word[i] != seq) {
+                result->torn++;
+                break;
+            }
+        }
+        if (seq <= last) {
+            result->reorder++;
+        } else if (seq != last + 1) {
+            result->gaps++;
+        }
+        last = seq;
+        result->consumed++;
+        queue.pop();
+        if (n % 256 == 128) {
+            // Fall behind without holding a frame, so drop-oldest evicts.
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+static void stress(rak3172_overflow_t policy, const char* name)
+{
+    stress_result_t produced = {};
+    stress_result_t consumed = {};
+    std::atomic<bool> done{false};
+
+    queue.clear();
+    queue.setPolicy(policy);
+    uint32_t dropped = queue.dropped();
+
+    std::thread consumer(consume, &consumed, &done);
+    std::thread producer(produce, &produced, &done);
+    producer.join();
+    consumer.join();
+    dropped = queue.dropped() - dropped;
+
+    printf("%-12s consumed %u dropped %u gaps %u\n", name, consumed.consumed, dropped, consumed.gaps);
+    CHECK_EQ(produced.produced, FRAMES);
+    CHECK_EQ(consumed.torn, 0);
+    CHECK_EQ(consumed.reorder, 0);
+    CHECK_EQ(consumed.repin, 0);
+    // Every frame is either read once or counted as dropped.
+    CHECK_EQ(consumed.consumed + dropped, FRAMES);
+    CHECK(queue.empty());
+    CHECK(consumed.consumed > 0);
+    if (policy == RAK3172_OVERFLOW_BLOCK) {
+        CHECK_EQ(dropped, 0);
+        CHECK_EQ(consumed.gaps, 0);
+    } else {
+        CHECK(dropped > 0);
+        CHECK(consumed.gaps > 0);
+    }
+}
+
+/**
+ * @brief Single-threaded checks of the pinned oldest frame under `RAK3172_OVERFLOW_DROP_OLDEST`.
+ */
+static void pinned()
+{
+    frame_t* frame;
+    queue.clear();
+    queue.setPolicy(RAK3172_OVERFLOW_DROP_OLDEST);
+    uint32_t dropped = queue.dropped();
+    for (uint32_t seq = 1; seq <= queue.capacity(); seq++) {
+        frame          = queue.reserve();
+        frame->word[0] = seq;
+        queue.commit();
+    }
+
+    // Unpinned: the oldest frame makes room for the new one.
+    frame          = queue.reserve();
+    frame->word[0] = 9;
+    queue.commit();
+    CHECK_EQ(queue.dropped() - dropped, 1);
+    frame = queue.front();
+    CHECK(frame != nullptr && frame->word[0] == 2);
+
+    // Pinned by front(): the new frame is dropped and the held one stays intact.
+    CHECK(queue.reserve() == nullptr);
+    CHECK_EQ(queue.dropped() - dropped, 2);
+    CHECK_EQ(frame->word[0], 2);
+
+    // pop() unpins, so the next overflow evicts the oldest frame again.
+    queue.pop();
+    CHECK_EQ(queue.size(), queue.capacity() - 1);
+    frame          = queue.reserve();
+    frame->word[0] = 10;
+    queue.commit();
+    frame = queue.reserve();
+    CHECK(frame != nullptr);
+    frame->word[0] = 11;
+    queue.commit();
+    CHECK_EQ(queue.dropped() - dropped, 3);
+    frame = queue.front();
+    CHECK(frame != nullptr && frame->word[0] == 4);
+    queue.clear();
+    CHECK(queue.empty());
+    CHECK(queue.front() == nullptr);
+}
+
+int main()
+{
+    pinned();
+    stress(RAK3172_OVERFLOW_DROP_OLDEST, "drop-oldest");
+    stress(RAK3172_OVERFLOW_DROP_NEWEST, "drop-newest");
+    stress(RAK3172_OVERFLOW_BLOCK, "block");
+    if (host_test_failures != 0) {
+        printf("%d check(s) failed\n", host_test_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
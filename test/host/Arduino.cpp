@@ -0,0 +1,250 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#include "Arduino.h"
+
+#include <time.h>
+#include <unistd.h>
+
+static uint64_t monotonicUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(monotonicUs() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)monotonicUs();
+}
+
+void delay(unsigned long ms)
+{
+    usleep(ms * 1000);
+}
+
+long random(long max)
+{
+    return max > 0 ? ::random() % max : 0;
+}
+
+long random(long min, long max)
+{
+    return max > min ? min + random(max - min) : min;
+}
+
+String::String(const char* str) : _buf(nullptr), _len(0), _capacity(0)
+{
+    if (str != nullptr) {
+        concat(str);
+    }
+}
+
+String::String(const String& str) : String(str.c_str())
+{
+}
+
+String::String(String&& str) : _buf(str._buf), _len(str._len), _capacity(str._capacity)
+{
+    str._buf      = nullptr;
+    str._len      = 0;
+    str._capacity = 0;
+}
+
+String::String(char c) : String()
+{
+    concat(c);
+}
+
+String::String(int value, unsigned char base) : String((long)value, base)
+{
+}
+
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base)
+{
+}
+
+String::String(long value, unsigned char base) : String()
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == HEX ? "%lx" : "%ld", value);
+    concat(buf);
+}
+
+String::String(unsigned long value, unsigned char base) : String()
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == HEX ? "%lx" : "%lu", value);
+    concat(buf);
+}
+
+String::~String()
+{
+    delete[] _buf;
+}
+
+String& String::operator=(const String& rhs)
+{
+    if (this != &rhs) {
+        _len = 0;
+        concat(rhs);
+    }
+    return *this;
+}
+
+String& String::operator=(String&& rhs)
+{
+    if (this != &rhs) {
+        delete[] _buf;
+        _buf          = rhs._buf;
+        _len          = rhs._len;
+        _capacity     = rhs._capacity;
+        rhs._buf      = nullptr;
+        rhs._len      = 0;
+        rhs._capacity = 0;
+    }
+    return *this;
+}
+
+String& String::operator=(const char* rhs)
+{
+    _len = 0;
+    concat(rhs);
+    return *this;
+}
+
+bool String::reserve(unsigned int size)
+{
+    if (_buf != nullptr && _capacity >= size) {
+        return true;
+    }
+    // Exact-size reallocation, as done by the Arduino WString.
+    char* buf = new char[size + 1];
+    if (_buf != nullptr) {
+        memcpy(buf, _buf, _len);
+        delete[] _buf;
+    }
+    buf[_len] = '\0';
+    _buf      = buf;
+    _capacity = size;
+    return true;
+}
+
+bool String::concat(const char* str, unsigned int length)
+{
+    if (str == nullptr) {
+        return false;
+    }
+    if (!reserve(_len + length)) {
+        return false;
+    }
+    memmove(_buf + _len, str, length);
+    _len += length;
+    _buf[_len] = '\0';
+    return true;
+}
+
+bool String::concat(const char* str)
+{
+    return str != nullptr && concat(str, strlen(str));
+}
+
+bool String::concat(const String& str)
+{
+    return concat(str.c_str(), str.length());
+}
+
+bool String::concat(char c)
+{
+    return concat(&c, 1);
+}
+
+String operator+(const String& lhs, const String& rhs)
+{
+    String str(lhs);
+    str.concat(rhs);
+    return str;
+}
+
+String operator+(const String& lhs, const char* rhs)
+{
+    String str(lhs);
+    str.concat(rhs);
+    return str;
+}
+
+String operator+(const char* lhs, const String& rhs)
+{
+    String str(lhs);
+    str.concat(rhs);
+    return str;
+}
+
+bool String::operator==(const String& rhs) const
+{
+    return _len == rhs._len && memcmp(c_str(), rhs.c_str(), _len) == 0;
+}
+
+bool String::operator==(const char* rhs) const
+{
+    return strcmp(c_str(), rhs != nullptr ? rhs : "") == 0;
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    String str;
+    if (to > _len) {
+        to = _len;
+    }
+    if (from < to) {
+        str.concat(_buf + from, to - from);
+    }
+    return str;
+}
+
+void String::toCharArray(char* buf, unsigned int size) const
+{
+    if (size == 0) {
+        return;
+    }
+    unsigned int n = _len < size - 1 ? _len : size - 1;
+    memcpy(buf, c_str(), n);
+    buf[n] = '\0';
+}
+
+size_t Print::write(const uint8_t* buf, size_t size)
+{
+    size_t n = 0;
+    while (size--) {
+        n += write(*buf++);
+    }
+    return n;
+}
+
+size_t Print::print(long value, int base)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), base == HEX ? "%lx" : "%ld", value);
+    return write(buf);
+}
+
+size_t Print::printf(const char* format, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (n < 0) {
+        return 0;
+    }
+    return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+}
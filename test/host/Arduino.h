@@ -0,0 +1,125 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core used to build the library on a Linux host.
+ *
+ * Only what the library and the host tests use is provided. `String` grows its buffer
+ * with exact-size allocations like the Arduino `WString` without its small string
+ * optimization, so heap counts measured on the host are an upper bound for the device.
+ */
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEX 16
+#define DEC 10
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+long random(long max);
+long random(long min, long max);
+
+class String {
+public:
+    String(const char* str = "");
+    String(const String& str);
+    String(String&& str);
+    explicit String(char c);
+    explicit String(int value, unsigned char base = DEC);
+    explicit String(unsigned int value, unsigned char base = DEC);
+    explicit String(long value, unsigned char base = DEC);
+    explicit String(unsigned long value, unsigned char base = DEC);
+    ~String();
+
+    String& operator=(const String& rhs);
+    String& operator=(String&& rhs);
+    String& operator=(const char* rhs);
+
+    bool reserve(unsigned int size);
+    bool concat(const char* str, unsigned int length);
+    bool concat(const char* str);
+    bool concat(const String& str);
+    bool concat(char c);
+
+    String& operator+=(const String& rhs)
+    {
+        concat(rhs);
+        return *this;
+    }
+    String& operator+=(const char* rhs)
+    {
+        concat(rhs);
+        return *this;
+    }
+    String& operator+=(char rhs)
+    {
+        concat(rhs);
+        return *this;
+    }
+
+    friend String operator+(const String& lhs, const String& rhs);
+    friend String operator+(const String& lhs, const char* rhs);
+    friend String operator+(const char* lhs, const String& rhs);
+
+    bool operator==(const String& rhs) const;
+    bool operator==(const char* rhs) const;
+    bool operator!=(const String& rhs) const
+    {
+        return !(*this == rhs);
+    }
+    bool operator!=(const char* rhs) const
+    {
+        return !(*this == rhs);
+    }
+    char operator[](unsigned int index) const
+    {
+        return index < _len ? _buf[index] : 0;
+    }
+
+    unsigned int length() const
+    {
+        return _len;
+    }
+    const char* c_str() const
+    {
+        return _buf != nullptr ? _buf : "";
+    }
+    long toInt() const
+    {
+        return atol(c_str());
+    }
+    const char* begin() const
+    {
+        return c_str();
+    }
+    const char* end() const
+    {
+        return c_str() + _len;
+    }
+    String substring(unsigned int from, unsigned int to) const;
+    void toCharArray(char* buf, unsigned int size) const;
+
+private:
+    char* _buf;
+    unsigned int _len;
+    unsigned int _capacity;
+};
+
+#include "Stream.h"
+
+#endif
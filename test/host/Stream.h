@@ -0,0 +1,63 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file Stream.h
+ * @brief `Print` and `Stream` of the host Arduino core, see `Arduino.h`.
+ */
+#ifndef _HOST_STREAM_H_
+#define _HOST_STREAM_H_
+
+#include "Arduino.h"
+
+class Print {
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t size);
+    size_t write(const char* str)
+    {
+        return write((const uint8_t*)str, strlen(str));
+    }
+
+    size_t print(const char* str)
+    {
+        return write(str);
+    }
+    size_t print(const String& str)
+    {
+        return write((const uint8_t*)str.c_str(), str.length());
+    }
+    size_t print(char c)
+    {
+        return write((uint8_t)c);
+    }
+    size_t print(long value, int base = DEC);
+    size_t print(int value, int base = DEC)
+    {
+        return print((long)value, base);
+    }
+    size_t println()
+    {
+        return write("\r\n");
+    }
+    template <typename T>
+    size_t println(const T& value)
+    {
+        return print(value) + println();
+    }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read()      = 0;
+    virtual int peek()      = 0;
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+#include "host_test.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+int host_test_failures = 0;
+
+static std::atomic<uint64_t> alloc_count{0};
+static std::atomic<uint64_t> alloc_bytes{0};
+
+void allocReset()
+{
+    alloc_count = 0;
+    alloc_bytes = 0;
+}
+
+host_alloc_stats_t allocStats()
+{
+    return {alloc_count.load(), alloc_bytes.load()};
+}
+
+static void* countedAlloc(size_t size)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    void* ptr = malloc(size != 0 ? size : 1);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(size_t size)
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](size_t size)
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
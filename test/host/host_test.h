@@ -0,0 +1,69 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file host_test.h
+ * @brief Checks and heap accounting shared by the host tests and benchmarks.
+ *
+ * Linking `host_test.cpp` replaces the global `operator new`/`operator delete`, so every
+ * heap allocation made by the library, including the ones of `String`, is counted.
+ */
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Heap usage since the last `allocReset()`.
+ */
+typedef struct {
+    uint64_t allocs; /**< Number of allocations */
+    uint64_t bytes;  /**< Bytes requested by these allocations */
+} host_alloc_stats_t;
+
+/**
+ * @brief Restarts the heap accounting.
+ */
+void allocReset();
+
+/**
+ * @brief Returns the heap usage since the last `allocReset()`.
+ */
+host_alloc_stats_t allocStats();
+
+/**
+ * @brief Number of failed checks, the exit status of a test.
+ */
+extern int host_test_failures;
+
+/**
+ * @def CHECK
+ * @brief Reports a failed condition and keeps running the test.
+ */
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++;                                           \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @def CHECK_EQ
+ * @brief Reports two integers that differ, with their values.
+ */
+#define CHECK_EQ(actual, expected)                                                                              \
+    do {                                                                                                        \
+        unsigned long long _a = (unsigned long long)(actual), _e = (unsigned long long)(expected);              \
+        if (_a != _e) {                                                                                         \
+            printf("%s:%d: CHECK_EQ failed: %s == %llu, expected %llu\n", __FILE__, __LINE__, #actual, _a, _e); \
+            host_test_failures++;                                                                               \
+        }                                                                                                       \
+    } while (0)
+
+#endif
@@ -0,0 +1,490 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file host_bench.cpp
+ * @brief Host benchmarks of the hex codec, the key checks and the response parser.
+ *
+ * The codec is also compared with the String-based implementation of the first release
+ * (`legacy`), in bytes per microsecond of payload. Received frames are measured in
+ * frames per second, both parsed directly and replayed from a trace through the UART
+ * demultiplexer.
+ *
+ * Each benchmark reports the time per operation and the heap allocations it makes,
+ * counted by `host_test.cpp`. Run `host_bench --quick` for a smoke run.
+ */
+#include "host_test.h"
+#include "rak3172_common.hpp"
+#include "rak3172_emulator.hpp"
+#include "rak3172_lorawan.hpp"
+#include "rak3172_p2p.hpp"
+#include "rak3172_trace.hpp"
+
+#include <chrono>
+
+static bool quick = false;
+
+/**
+ * @brief Keeps the compiler from optimizing away a benchmarked result.
+ */
+template <typename T>
+static inline void keep(T& value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+/**
+ * @brief Runs `op` until about 200 ms (1 ms with `--quick`) have passed and prints its cost.
+ *
+ * @param name Name of the benchmark.
+ * @param size Payload size in bytes, 0 if not applicable.
+ * @param op The operation, called once per iteration.
+ * @return The time per operation in nanoseconds.
+ */
+template <typename F>
+static double bench(const char* name, size_t size, F op)
+{
+    using clock      = std::chrono::steady_clock;
+    uint64_t budget  = quick ? 1000000 : 200000000;
+    uint64_t iters   = 1;
+    uint64_t elapsed = 0;
+    host_alloc_stats_t heap;
+
+    op();
+    for (;;) {
+        allocReset();
+        clock::time_point start = clock::now();
+        for (uint64_t i = 0; i < iters; i++) {
+            op();
+        }
+        elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        heap    = allocStats();
+        if (elapsed >= budget || iters >= (1ULL << 32)) {
+            break;
+        }
+        iters *= elapsed < budget / 16 ? 8 : 2;
+    }
+    double ns = (double)elapsed / iters;
+    printf("%-30s %5zu %12.1f ns/op %10.1f B/op %8.2f allocs/op", name, size, ns, (double)heap.bytes / iters,
+           (double)heap.allocs / iters);
+    if (size > 0) {
+        printf(" %10.1f B/us", size * 1000.0 / ns);
+    }
+    printf("\n");
+    return ns;
+}
+
+/**
+ * @brief Prints how much faster the current implementation is than the legacy one.
+ */
+static void speedup(double legacy_ns, double current_ns)
+{
+    printf("%-30s %5s %11.1fx faster\n", "", "", legacy_ns / current_ns);
+}
+
+/**
+ * @brief Prints the number of operations per second.
+ */
+static void rate(double ns, const char* unit)
+{
+    printf("%-30s %5s %12.0f %s/s\n", "", "", 1e9 / ns, unit);
+}
+
+/**
+ * @brief The String-based codec of the first release, kept as the baseline.
+ */
+namespace legacy {
+
+String encodeMsg(String str)
+{
+    char buf[str.length() + 1];
+    char tempbuf[((str.length() + 1) * 2)];
+    str.toCharArray(buf, str.length() + 1);
+    int i = 0;
+    for (const char* p = buf; *p; ++p) {
+        sprintf((char*)(tempbuf + i), "%02x", *p);
+        i += 2;
+    }
+    return String(tempbuf);
+}
+
+String decodeMsg(String hexEncoded)
+{
+    if ((hexEncoded.length() % 2) == 0) {
+        char buf[hexEncoded.length() + 1];
+        char tempbuf[((hexEncoded.length() + 1))];
+        hexEncoded.toCharArray(buf, hexEncoded.length() + 1);
+        int i = 0;
+        for (unsigned int loop = 2; loop < hexEncoded.length() + 1; loop += 2) {
+            String tmpstr = hexEncoded.substring(loop - 2, loop);
+            sprintf(&tempbuf[i], "%c", (int)strtoul(tmpstr.c_str(), nullptr, 16));
+            i++;
+        }
+        return String(tempbuf);
+    } else {
+        return hexEncoded;
+    }
+}
+
+String bytes2hex(const uint8_t* buf, size_t size)
+{
+    String res = "";
+    for (size_t i = 0; i < size; i++) {
+        if (buf[i] <= 0x0f) {
+            res += "0";
+        }
+        res += String(buf[i], HEX);
+    }
+    return res;
+}
+
+void hex2bytes(String hexEncoded, uint8_t* buf, size_t size)
+{
+    if ((hexEncoded.length() & 1) == 0) {
+        char tempbuf[((hexEncoded.length() + 1))];
+        hexEncoded.toCharArray(tempbuf, hexEncoded.length() + 1);
+        int i = 0;
+        for (unsigned int loop = 2; loop < hexEncoded.length() + 1; loop += 2) {
+            String tmpstr = hexEncoded.substring(loop - 2, loop);
+            buf[i]        = strtoul(tmpstr.c_str(), nullptr, 16);
+            i++;
+        }
+    }
+}
+
+long hex2bin(String hex)
+{
+    if ((hex.length() & 1) == 0) {
+        char buf[hex.length() + 1];
+        hex.toCharArray(buf, hex.length() + 1);
+        long byte = 0;
+        for (unsigned int loop = 2; loop < hex.length() + 1; loop += 2) {
+            String tmpstr = hex.substring(loop - 2, loop);
+            byte          = byte << 8;
+            byte |= strtoul(tmpstr.c_str(), nullptr, 16);
+        }
+        return byte;
+    } else {
+        return false;
+    }
+}
+
+bool checkString(const String& key, size_t len)
+{
+    if (key.length() != len) {
+        return false;
+    }
+    for (char c : key) {
+        if (!isxdigit(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace legacy
+
+/**
+ * @brief Exposes the line demultiplexer of the driver.
+ */
+class ResponseParser : public RAK3172 {
+public:
+    using RAK3172::feed;
+};
+
+static void benchCodec()
+{
+    static const size_t sizes[] = {1, 16, 64, 242};
+    uint8_t bytes[242];
+    char hex[sizeof(bytes) * 2 + 1];
+
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = i * 37 + 11;
+    }
+    for (size_t size : sizes) {
+        String text((const char*)nullptr);
+        bytes2hex(bytes, size, hex, sizeof(hex));
+        String encoded(hex);
+        for (size_t i = 0; i < size; i++) {
+            text.concat((char)('a' + i % 26));
+        }
+        String encoded_text = encodeMsg(text);
+
+        bench("bytes2hex(buf)", size, [&] {
+            size_t n = bytes2hex(bytes, size, hex, sizeof(hex));
+            keep(n);
+        });
+        bench("bytes2hex -> String", size, [&] {
+            String res = bytes2hex(bytes, size);
+            keep(res);
+        });
+        bench("hex2bytes(buf)", size, [&] {
+            int n = hex2bytes(hex, size * 2, bytes, sizeof(bytes));
+            keep(n);
+        });
+        bench("hex2bytes(String)", size, [&] {
+            hex2bytes(encoded, bytes, sizeof(bytes));
+            keep(bytes);
+        });
+        bench("encodeMsg", size, [&] {
+            String res = encodeMsg(text);
+            keep(res);
+        });
+        bench("decodeMsg", size, [&] {
+            String res = decodeMsg(encoded_text);
+            keep(res);
+        });
+        bench("isHex", size, [&] {
+            bool ok = isHex(hex, size * 2);
+            keep(ok);
+        });
+    }
+
+    String word("0001F4A2");
+    bench("hex2bin", 4, [&] {
+        long value = hex2bin(word);
+        keep(value);
+    });
+
+    const char* key = "00112233445566778899AABBCCDDEEFF";
+    String key_string(key);
+    bench("checkString(const char*)", 16, [&] {
+        bool ok = checkString(key, 32);
+        keep(ok);
+    });
+    bench("checkString(String)", 16, [&] {
+        bool ok = checkString(key_string, 32);
+        keep(ok);
+    });
+}
+
+static void benchLegacyCodec()
+{
+    static const size_t sizes[] = {16, 64, 242};
+    uint8_t bytes[242];
+    char hex[sizeof(bytes) * 2 + 1];
+
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = i * 37 + 11;
+    }
+    for (size_t size : sizes) {
+        String text((const char*)nullptr);
+        for (size_t i = 0; i < size; i++) {
+            text.concat((char)('a' + i % 26));
+        }
+        bytes2hex(bytes, size, hex, sizeof(hex));
+        String encoded(hex);
+        String encoded_text = encodeMsg(text);
+        double legacy_ns;
+
+        legacy_ns = bench("legacy encodeMsg", size, [&] {
+            String res = legacy::encodeMsg(text);
+            keep(res);
+        });
+        speedup(legacy_ns, bench("encodeMsg", size, [&] {
+                    String res = encodeMsg(text);
+                    keep(res);
+                }));
+        legacy_ns = bench("legacy decodeMsg", size, [&] {
+            String res = legacy::decodeMsg(encoded_text);
+            keep(res);
+        });
+        speedup(legacy_ns, bench("decodeMsg", size, [&] {
+                    String res = decodeMsg(encoded_text);
+                    keep(res);
+                }));
+        legacy_ns = bench("legacy bytes2hex -> String", size, [&] {
+            String res = legacy::bytes2hex(bytes, size);
+            keep(res);
+        });
+        speedup(legacy_ns, bench("bytes2hex -> String", size, [&] {
+                    String res = bytes2hex(bytes, size);
+                    keep(res);
+                }));
+        speedup(legacy_ns, bench("bytes2hex(buf)", size, [&] {
+                    size_t n = bytes2hex(bytes, size, hex, sizeof(hex));
+                    keep(n);
+                }));
+        legacy_ns = bench("legacy hex2bytes(String)", size, [&] {
+            legacy::hex2bytes(encoded, bytes, sizeof(bytes));
+            keep(bytes);
+        });
+        speedup(legacy_ns, bench("hex2bytes(String)", size, [&] {
+                    hex2bytes(encoded, bytes, sizeof(bytes));
+                    keep(bytes);
+                }));
+        speedup(legacy_ns, bench("hex2bytes(buf)", size, [&] {
+                    int n = hex2bytes(hex, size * 2, bytes, sizeof(bytes));
+                    keep(n);
+                }));
+    }
+
+    String word("0001F4A2");
+    double legacy_ns = bench("legacy hex2bin", 4, [&] {
+        long value = legacy::hex2bin(word);
+        keep(value);
+    });
+    speedup(legacy_ns, bench("hex2bin", 4, [&] {
+                long value = hex2bin(word);
+                keep(value);
+            }));
+
+    String key("00112233445566778899AABBCCDDEEFF");
+    legacy_ns = bench("legacy checkString", 16, [&] {
+        bool ok = legacy::checkString(key, 32);
+        keep(ok);
+    });
+    speedup(legacy_ns, bench("checkString(String)", 16, [&] {
+                bool ok = checkString(key, 32);
+                keep(ok);
+            }));
+}
+
+/**
+ * @brief Appends a record in the format of `RAK3172TraceRecorder`, see `RAK3172_TRACE_HEADER_SIZE`.
+ */
+static size_t traceRecord(uint8_t* trace, size_t offset, bool rx, const char* data)
+{
+    size_t len = strlen(data);
+    memset(trace + offset, 0, 4);
+    trace[offset + 4] = len & 0xFF;
+    trace[offset + 5] = (len >> 8) | (rx ? 0x80 : 0);
+    memcpy(trace + offset + RAK3172_TRACE_HEADER_SIZE, data, len);
+    return offset + RAK3172_TRACE_HEADER_SIZE + len;
+}
+
+/**
+ * @brief Builds the trace of the `AT` exchange of `init()` followed by one received line.
+ *
+ * @param start Receives the offset of the received line, where the replay is rewound to.
+ * @return The size of the trace.
+ */
+static size_t frameTrace(uint8_t* trace, const char* line, size_t* start)
+{
+    char rx[RAK3172_LINE_SIZE + 2];
+    size_t size = traceRecord(trace, 0, false, "AT\r\n");
+    *start      = traceRecord(trace, size, true, "OK\r\n");
+    snprintf(rx, sizeof(rx), "%s\r\n", line);
+    return traceRecord(trace, *start, true, rx);
+}
+
+static void benchFrames()
+{
+    static const size_t sizes[] = {1, 64, 242};
+    static uint8_t trace[RAK3172_LINE_SIZE + 32];
+    uint8_t payload[242];
+    char hex[sizeof(payload) * 2 + 1];
+    char line[RAK3172_LINE_SIZE];
+    size_t len;
+    size_t start;
+
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = i * 37 + 11;
+    }
+    for (size_t size : sizes) {
+        bytes2hex(payload, size, hex, sizeof(hex));
+
+        len = snprintf(line, sizeof(line), "+EVT:RX_1:-40:8:UNICAST:2:%s", hex);
+        RAK3172TraceReplay lorawan_wire(trace, frameTrace(trace, line, &start));
+        RAK3172LoRaWAN lorawan;
+        // Only the `AT` exchange of the base class, without the start-up delay of the drivers.
+        CHECK(lorawan.RAK3172::init(&lorawan_wire));
+        lorawan.update();
+        CHECK(lorawan.peek() != nullptr && (size_t)lorawan.peek()->len == size);
+        CHECK(lorawan_wire.done());
+        CHECK_EQ(lorawan_wire.mismatches(), 0);
+        lorawan.flush();
+        rate(bench("LoRaWAN parse", size,
+                   [&] {
+                       lorawan.parse(line, len);
+                       lorawan.pop();
+                   }),
+             "frames");
+        rate(bench("LoRaWAN update", size,
+                   [&] {
+                       lorawan_wire.rewind(start);
+                       lorawan.update();
+                       lorawan.pop();
+                   }),
+             "frames");
+
+        len = snprintf(line, sizeof(line), "+EVT:RXP2P:-40:8:%s", hex);
+        RAK3172TraceReplay p2p_wire(trace, frameTrace(trace, line, &start));
+        RAK3172P2P p2p;
+        CHECK(p2p.RAK3172::init(&p2p_wire));
+        p2p.update();
+        CHECK(p2p.peek() != nullptr && (size_t)p2p.peek()->len == size);
+        CHECK(p2p_wire.done());
+        CHECK_EQ(p2p_wire.mismatches(), 0);
+        p2p.flush();
+        rate(bench("P2P parse", size,
+                   [&] {
+                       p2p.parse(line, len);
+                       p2p.pop();
+                   }),
+             "frames");
+        rate(bench("P2P update", size,
+                   [&] {
+                       p2p_wire.rewind(start);
+                       p2p.update();
+                       p2p.pop();
+                   }),
+             "frames");
+    }
+}
+
+static void benchParser()
+{
+    static ResponseParser parser;
+    static const char* responses[] = {
+        "OK\r\n",
+        "AT+DR=3\r\nOK\r\n",
+        "AT+DEVEUI=70B3D57ED0000001\r\nOK\r\n",
+        "AT+APPKEY=00112233445566778899AABBCCDDEEFF\r\nOK\r\n",
+    };
+    char name[40];
+    char value[RAK3172_LINE_SIZE];
+
+    for (const char* response : responses) {
+        size_t len = strlen(response);
+        snprintf(name, sizeof(name), "feed %.*s", (int)strcspn(response, "=\r"), response);
+        bench(name, len, [&] {
+            rak3172_result_t result;
+            value[0] = '\0';
+            for (size_t i = 0; i < len; i++) {
+                if (parser.feed(response[i], &result, value, sizeof(value))) {
+                    break;
+                }
+            }
+            keep(result);
+        });
+    }
+
+    // Whole command round trip through the emulator, including its own parsing.
+    static RAK3172Emulator emulator;
+    static ResponseParser driver;
+    emulator.setParam("DEVEUI", "70B3D57ED0000001");
+    driver.init(&emulator);
+    bench("getCommand -> String emulated", 0, [&] {
+        String res = driver.getCommand("AT+DEVEUI=?");
+        keep(res);
+    });
+    bench("getCommand(buf) emulated", 0, [&] {
+        bool ok = driver.getCommand("AT+DEVEUI=?", value, sizeof(value));
+        keep(ok);
+    });
+}
+
+int main(int argc, char** argv)
+{
+    quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+    printf("%-30s %5s %18s %15s %18s %15s\n", "benchmark", "bytes", "time", "heap", "allocations", "throughput");
+    benchCodec();
+    benchLegacyCodec();
+    benchParser();
+    benchFrames();
+    return host_test_failures != 0;
+}
@@ -0,0 +1,160 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file trace_replay.cpp
+ * @brief Plays a trace recorded by `RAK3172TraceRecorder` back through the driver.
+ *
+ * Usage: trace_replay [--p2p] [--realtime] <trace-file>
+ *
+ * The commands recorded in the trace are sent again through `RAK3172LoRaWAN` (or
+ * `RAK3172P2P` with `--p2p`) on a `RAK3172TraceReplay`, so the recorded module output runs
+ * through the real response parser, event handlers and frame parser. Commands, events and
+ * received frames are printed. The exit status is non-zero if a command failed or the
+ * driver wrote other bytes than the recorded ones.
+ */
+#include <stdio.h>
+#include "rak3172_lorawan.hpp"
+#include "rak3172_p2p.hpp"
+#include "rak3172_trace.hpp"
+
+static uint8_t trace[1 << 20];
+
+static void printEvent(const rak3172_event_t& event, void* ctx)
+{
+    printf("< %.*s\n", (int)event.len, event.line);
+}
+
+static void printFrame(const char* payload, int len)
+{
+    printf(" payload");
+    for (int i = 0; i < len; i++) {
+        printf(" %02x", (uint8_t)payload[i]);
+    }
+    printf("\n");
+}
+
+static void printLoRaWANFrame(const lorawan_frame_t& frame, void* ctx)
+{
+    printf("  port %d, rssi %d, snr %d,", frame.port, frame.rssi, frame.snr);
+    printFrame(frame.payload, frame.len);
+}
+
+static void printP2PFrame(const p2p_frame_t& frame, void* ctx)
+{
+    printf("  rssi %d, snr %d,", frame.rssi, frame.snr);
+    printFrame(frame.payload, frame.len);
+}
+
+/**
+ * @brief Handles the module output released so far.
+ */
+template <typename T>
+static void drain(T& driver, RAK3172TraceReplay& replay)
+{
+    do {
+        driver.update();
+    } while (replay.available() > 0);
+}
+
+/**
+ * @brief Sends every recorded command again; the first `AT` was already sent by `init()`.
+ *
+ * @return The number of commands that failed.
+ */
+template <typename T>
+static int play(T& driver, RAK3172TraceReplay& replay, size_t size, bool realtime)
+{
+    char cmd[RAK3172_LINE_SIZE];
+    size_t len  = 0;
+    bool first  = true;
+    int failed  = 0;
+    size_t info = 0;
+
+    driver.onEvent(printEvent);
+    if (!driver.RAK3172::init(&replay)) {
+        printf("trace does not start with AT\n");
+    }
+    for (size_t offset = 0; offset + RAK3172_TRACE_HEADER_SIZE <= size;
+         offset += RAK3172_TRACE_HEADER_SIZE + (info & 0x7FFF)) {
+        info = trace[offset + 4] | (trace[offset + 5] << 8);
+        if (info & 0x8000) {
+            continue;
+        }
+        for (size_t i = 0; i < (info & 0x7FFF) && offset + RAK3172_TRACE_HEADER_SIZE + i < size; i++) {
+            char c = trace[offset + RAK3172_TRACE_HEADER_SIZE + i];
+            if (c != '\n') {
+                if (c != '\r' && len < sizeof(cmd) - 1) {
+                    cmd[len++] = c;
+                }
+                continue;
+            }
+            cmd[len] = '\0';
+            len      = 0;
+            if (first && strcmp(cmd, "AT") == 0) {
+                first = false;
+                continue;
+            }
+            first = false;
+            drain(driver, replay);
+            printf("> %s\n", cmd);
+            if (!driver.sendCommand(cmd)) {
+                printf("  failed: %d\n", driver.getLastResult());
+                failed++;
+            }
+        }
+    }
+    // In real time the last events are still held back until their recorded time.
+    drain(driver, replay);
+    while (realtime && !replay.done()) {
+        delay(1);
+        drain(driver, replay);
+    }
+    return failed;
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = nullptr;
+    bool p2p_mode    = false;
+    bool realtime    = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--p2p") == 0) {
+            p2p_mode = true;
+        } else if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == nullptr) {
+        printf("usage: %s [--p2p] [--realtime] <trace-file>\n", argv[0]);
+        return 2;
+    }
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        perror(path);
+        return 2;
+    }
+    size_t size = fread(trace, 1, sizeof(trace), f);
+    fclose(f);
+
+    static RAK3172TraceReplay replay(trace, size, realtime);
+    static RAK3172LoRaWAN lorawan;
+    static RAK3172P2P p2p;
+    int failed;
+    if (p2p_mode) {
+        p2p.onReceive(printP2PFrame);
+        failed = play(p2p, replay, size, realtime);
+    } else {
+        lorawan.onReceive(printLoRaWANFrame, nullptr);
+        failed = play(lorawan, replay, size, realtime);
+    }
+    printf("%zu bytes, %d failed command(s), %u mismatched byte(s)%s\n", size, failed, replay.mismatches(),
+           replay.done() ? "" : ", trace not fully replayed");
+    return failed != 0 || replay.mismatches() != 0 || !replay.done();
+}
@@ -0,0 +1,273 @@
+/*
+ *SPDX-FileCopyrightText: 2024 M5Stack Technology CO LTD
+ *
+ *SPDX-License-Identifier: MIT
+ */
+
+/**
+ * @file trace_replay_test.cpp
+ * @brief Record a session with `RAK3172TraceRecorder` and replay it with `RAK3172TraceReplay`.
+ *
+ * A LoRaWAN session (join, uplink, downlink) and a P2P session (send, receive) are run
+ * against `RAK3172Emulator` through the recorder. Each trace is then replayed through a
+ * fresh driver, at full speed and in real time, which must issue the same commands, see
+ * the same frames and call the same callbacks.
+ *
+ * Usage: trace_replay_test [file] — also writes the LoRaWAN trace to `file`.
+ */
+#include <stdio.h>
+#include "host_test.h"
+#include "rak3172_emulator.hpp"
+#include "rak3172_lorawan.hpp"
+#include "rak3172_p2p.hpp"
+#include "rak3172_trace.hpp"
+
+static const char* DEVEUI = "70B3D57ED0000001";
+static const char* APPEUI = "0000000000000000";
+static const char* APPKEY = "00112233445566778899AABBCCDDEEFF";
+
+/**
+ * @brief Delay of the emulated join and uplink, so real-time replay has a span to keep.
+ */
+static const uint32_t AIRTIME_MS = 20;
+
+/**
+ * @brief What the callbacks saw during one session.
+ */
+typedef struct {
+    int joins;
+    int sends;
+    int frames;
+    int port;
+    int len;
+    uint8_t payload[4];
+} observed_t;
+
+template <typename T>
+static bool waitFor(T& driver, const int& count)
+{
+    uint32_t start = millis();
+    while (count == 0 && millis() - start < 2000) {
+        driver.update();
+        delay(1);
+    }
+    return count > 0;
+}
+
+static void onJoin(bool success, void* ctx)
+{
+    ((observed_t*)ctx)->joins += success;
+}
+
+static void onSend(void* ctx)
+{
+    ((observed_t*)ctx)->sends++;
+}
+
+static void onLoRaWANFrame(const lorawan_frame_t& frame, void* ctx)
+{
+    observed_t* seen = (observed_t*)ctx;
+    seen->frames++;
+    seen->port = frame.port;
+    seen->len  = frame.len;
+    memcpy(seen->payload, frame.payload, frame.len < 4 ? frame.len : 4);
+}
+
+static void onP2PFrame(const p2p_frame_t& frame, void* ctx)
+{
+    observed_t* seen = (observed_t*)ctx;
+    seen->frames++;
+    seen->len = frame.len;
+    memcpy(seen->payload, frame.payload, frame.len < 4 ? frame.len : 4);
+}
+
+/**
+ * @brief Runs the LoRaWAN session; `emulator` scripts the module while recording, else `nullptr`.
+ */
+static void lorawanSession(RAK3172LoRaWAN& lorawan, RAK3172Transport* wire, RAK3172Emulator* emulator,
+                           observed_t* seen)
+{
+    static const uint8_t payload[] = {0x01, 0x02, 0x03};
+
+    lorawan.onJoin(onJoin, seen);
+    lorawan.onSend(onSend, seen);
+    lorawan.onReceive(onLoRaWANFrame, seen);
+    CHECK(lorawan.init(wire));
+    CHECK(lorawan.setOTAA(DEVEUI, APPEUI, APPKEY));
+    CHECK(lorawan.join());
+    CHECK(waitFor(lorawan, seen->joins));
+    CHECK_EQ(lorawan.send(payload, sizeof(payload), 2), sizeof(payload));
+    CHECK(waitFor(lorawan, seen->sends));
+    if (emulator != nullptr) {
+        CHECK(emulator->injectEvent("+EVT:RX_1:-40:8:UNICAST:2:cafe", AIRTIME_MS));
+    }
+    CHECK(waitFor(lorawan, seen->frames));
+}
+
+/**
+ * @brief Runs the P2P session; `emulator` scripts the module while recording, else `nullptr`.
+ */
+static void p2pSession(RAK3172P2P& p2p, RAK3172Transport* wire, RAK3172Emulator* emulator, observed_t* seen)
+{
+    static const uint8_t payload[] = {0x01, 0x02, 0x03};
+
+    p2p.onSend(onSend, seen);
+    p2p.onReceive(onP2PFrame, seen);
+    CHECK(p2p.init(wire));
+    CHECK(p2p.config(868000000, 7, 0, 0, 8, 14));
+    CHECK_EQ(p2p.write(payload, sizeof(payload)), sizeof(payload));
+    CHECK(waitFor(p2p, seen->sends));
+    if (emulator != nullptr) {
+        CHECK(emulator->injectEvent("+EVT:RXP2P:-40:8:cafe", AIRTIME_MS));
+    }
+    CHECK(waitFor(p2p, seen->frames));
+}
+
+static void checkLoRaWAN(const observed_t& seen)
+{
+    CHECK_EQ(seen.joins, 1);
+    CHECK_EQ(seen.sends, 1);
+    CHECK_EQ(seen.frames, 1);
+    CHECK_EQ(seen.port, 2);
+    CHECK_EQ(seen.len, 2);
+    CHECK_EQ(seen.payload[0], 0xCA);
+    CHECK_EQ(seen.payload[1], 0xFE);
+}
+
+static void checkP2P(const observed_t& seen)
+{
+    CHECK_EQ(seen.sends, 1);
+    CHECK_EQ(seen.frames, 1);
+    CHECK_EQ(seen.len, 2);
+    CHECK_EQ(seen.payload[0], 0xCA);
+    CHECK_EQ(seen.payload[1], 0xFE);
+}
+
+/**
+ * @brief Returns the time between the first and the last record of a trace.
+ */
+static uint32_t span(const uint8_t* trace, size_t size)
+{
+    uint32_t first = 0;
+    uint32_t last  = 0;
+    for (size_t offset = 0; offset + RAK3172_TRACE_HEADER_SIZE <= size;) {
+        const uint8_t* p = trace + offset;
+        uint32_t time_us = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+        if (offset == 0) {
+            first = time_us;
+        }
+        last = time_us;
+        offset += RAK3172_TRACE_HEADER_SIZE + ((p[4] | (p[5] << 8)) & 0x7FFF);
+    }
+    return last - first;
+}
+
+static size_t recordLoRaWAN(uint8_t* trace, size_t size)
+{
+    static RAK3172Emulator emulator;
+    static RAK3172TraceRecorder recorder(&emulator);
+    static RAK3172LoRaWAN lorawan;
+    observed_t seen = {};
+
+    emulator.setJoinResult(AIRTIME_MS);
+    emulator.setTxDelay(AIRTIME_MS);
+    lorawanSession(lorawan, &recorder, &emulator, &seen);
+    checkLoRaWAN(seen);
+    CHECK_EQ(recorder.overruns(), 0);
+    size = recorder.drain(trace, size);
+    CHECK(size > 0);
+    CHECK_EQ(recorder.size(), 0);
+    return size;
+}
+
+static size_t recordP2P(uint8_t* trace, size_t size)
+{
+    static RAK3172Emulator emulator;
+    static RAK3172TraceRecorder recorder(&emulator);
+    static RAK3172P2P p2p;
+    observed_t seen = {};
+
+    emulator.setTxDelay(AIRTIME_MS);
+    p2pSession(p2p, &recorder, &emulator, &seen);
+    checkP2P(seen);
+    CHECK_EQ(recorder.overruns(), 0);
+    size = recorder.drain(trace, size);
+    CHECK(size > 0);
+    return size;
+}
+
+static void replayLoRaWAN(const uint8_t* trace, size_t size, bool realtime)
+{
+    RAK3172TraceReplay replay(trace, size, realtime);
+    RAK3172LoRaWAN lorawan;
+    observed_t seen = {};
+    uint32_t start  = micros();
+
+    lorawanSession(lorawan, &replay, nullptr, &seen);
+    checkLoRaWAN(seen);
+    CHECK(replay.done());
+    CHECK_EQ(replay.mismatches(), 0);
+    if (realtime) {
+        CHECK(micros() - start >= span(trace, size));
+    }
+}
+
+static void replayP2P(const uint8_t* trace, size_t size, bool realtime)
+{
+    RAK3172TraceReplay replay(trace, size, realtime);
+    RAK3172P2P p2p;
+    observed_t seen = {};
+    uint32_t start  = micros();
+
+    p2pSession(p2p, &replay, nullptr, &seen);
+    checkP2P(seen);
+    CHECK(replay.done());
+    CHECK_EQ(replay.mismatches(), 0);
+    if (realtime) {
+        CHECK(micros() - start >= span(trace, size));
+    }
+}
+
+/**
+ * @brief A replay that is sent other commands than the recorded ones reports mismatches.
+ */
+static void replayDiverging(const uint8_t* trace, size_t size)
+{
+    RAK3172TraceReplay replay(trace, size);
+    RAK3172LoRaWAN lorawan;
+
+    CHECK(lorawan.init(&replay));
+    CHECK_EQ(replay.mismatches(), 0);
+    lorawan.setDR(5);
+    CHECK(replay.mismatches() > 0);
+}
+
+int main(int argc, char** argv)
+{
+    static uint8_t lorawan_trace[RAK3172_TRACE_SIZE];
+    static uint8_t p2p_trace[RAK3172_TRACE_SIZE];
+    size_t lorawan_size = recordLoRaWAN(lorawan_trace, sizeof(lorawan_trace));
+    size_t p2p_size     = recordP2P(p2p_trace, sizeof(p2p_trace));
+
+    CHECK(span(lorawan_trace, lorawan_size) >= 3 * AIRTIME_MS * 1000);
+    for (bool realtime : {false, true}) {
+        replayLoRaWAN(lorawan_trace, lorawan_size, realtime);
+        replayP2P(p2p_trace, p2p_size, realtime);
+    }
+    replayDiverging(lorawan_trace, lorawan_size);
+
+    if (argc > 1) {
+        FILE* f = fopen(argv[1], "wb");
+        CHECK(f != nullptr);
+        if (f != nullptr) {
+            CHECK_EQ(fwrite(lorawan_trace, 1, lorawan_size, f), lorawan_size);
+            fclose(f);
+        }
+    }
+    if (host_test_failures != 0) {
+        printf("%d check(s) failed\n", host_test_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}